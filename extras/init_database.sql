@@ -71,3 +71,14 @@ CREATE TABLE ignore (avatar_id INTEGER,
                      PRIMARY KEY(avatar_id, ignore_avatar_id)
                      FOREIGN KEY(avatar_id) REFERENCES avatar(id) ON DELETE CASCADE,
                      FOREIGN KEY(ignore_avatar_id) REFERENCES avatar(id) ON DELETE CASCADE);
+
+CREATE INDEX persistent_message_avatar_id_status ON persistent_message (avatar_id, status);
+
+CREATE INDEX friend_friend_avatar_id ON friend (friend_avatar_id);
+
+CREATE INDEX ignore_ignore_avatar_id ON ignore (ignore_avatar_id);
+
+CREATE INDEX room_room_address ON room (room_address);
+
+-- Schema version applied by the migrations in SQLiteChatStorage.cpp
+PRAGMA user_version = 1;
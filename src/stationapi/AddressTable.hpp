@@ -0,0 +1,63 @@
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Small integer handle for an interned address. */
+using AddressAtom = uint32_t;
+
+/** Atom that never names an address, returned for unknown lookups. */
+const AddressAtom NULL_ADDRESS_ATOM = 0;
+
+/** Interns gateway addresses such as "SWG+galaxy+zone" as dense atoms.
+ *
+ * Addresses are converted to atoms once where they enter from the wire and are
+ * compared, hashed and used as indexes as plain integers from then on. Atoms
+ * are assigned sequentially from 1 and are never released, the table only
+ * grows by the number of distinct gateway addresses seen. Not thread safe.
+ */
+class AddressTable {
+public:
+    AddressTable() { addresses_.push_back(&empty_); }
+
+    AddressTable(const AddressTable&) = delete;
+    AddressTable& operator=(const AddressTable&) = delete;
+
+    /** Returns the atom for the address, assigning a new one if needed. */
+    AddressAtom Intern(const std::u16string& address) {
+        auto find_iter = atoms_.find(address);
+        if (find_iter != std::end(atoms_)) {
+            return find_iter->second;
+        }
+
+        auto atom = static_cast<AddressAtom>(addresses_.size());
+        auto insert_iter = atoms_.emplace(address, atom).first;
+        addresses_.push_back(&insert_iter->first);
+
+        return atom;
+    }
+
+    /** Returns the atom for an address already interned, or NULL_ADDRESS_ATOM. */
+    AddressAtom Find(const std::u16string& address) const {
+        auto find_iter = atoms_.find(address);
+        return find_iter != std::end(atoms_) ? find_iter->second : NULL_ADDRESS_ATOM;
+    }
+
+    /** Returns the address for an atom. The reference stays valid for the
+     * lifetime of the table.
+     */
+    const std::u16string& GetAddress(AddressAtom atom) const {
+        return atom < addresses_.size() ? *addresses_[atom] : empty_;
+    }
+
+    /** One past the largest atom handed out, for sizing atom indexed tables. */
+    size_t GetAtomLimit() const { return addresses_.size(); }
+
+private:
+    std::unordered_map<std::u16string, AddressAtom> atoms_;
+    std::vector<const std::u16string*> addresses_;
+    std::u16string empty_;
+};
@@ -0,0 +1,67 @@
+
+#pragma once
+
+#include "BufferWriter.hpp"
+
+#include <memory>
+#include <vector>
+
+/** A free list of reusable output buffers.
+ *
+ * Buffers are handed out as leases that clear the buffer and return it to the
+ * pool when they go out of scope. Buffers that grew past the retained capacity
+ * while encoding an unusually large message are trimmed on return.
+ */
+class BufferPool {
+public:
+    class Lease {
+    public:
+        Lease(BufferPool* pool, std::unique_ptr<BufferWriter> buffer)
+            : pool_{pool}
+            , buffer_{std::move(buffer)} {}
+
+        Lease(Lease&& other) = default;
+        Lease& operator=(Lease&& other) = delete;
+
+        ~Lease() {
+            if (buffer_) {
+                pool_->Release(std::move(buffer_));
+            }
+        }
+
+        BufferWriter& operator*() { return *buffer_; }
+        BufferWriter* operator->() { return buffer_.get(); }
+
+    private:
+        BufferPool* pool_;
+        std::unique_ptr<BufferWriter> buffer_;
+    };
+
+    explicit BufferPool(size_t initialCapacity = 512, size_t maxRetainedCapacity = 64 * 1024)
+        : initialCapacity_{initialCapacity}
+        , maxRetainedCapacity_{maxRetainedCapacity} {}
+
+    Lease Acquire() {
+        if (free_.empty()) {
+            return Lease{this, std::make_unique<BufferWriter>(initialCapacity_)};
+        }
+
+        auto buffer = std::move(free_.back());
+        free_.pop_back();
+
+        return Lease{this, std::move(buffer)};
+    }
+
+    size_t GetFreeCount() const { return free_.size(); }
+
+private:
+    void Release(std::unique_ptr<BufferWriter> buffer) {
+        buffer->clear();
+        buffer->shrink(maxRetainedCapacity_);
+        free_.push_back(std::move(buffer));
+    }
+
+    size_t initialCapacity_;
+    size_t maxRetainedCapacity_;
+    std::vector<std::unique_ptr<BufferWriter>> free_;
+};
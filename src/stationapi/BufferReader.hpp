@@ -0,0 +1,52 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+/** A bounds-checked, non-owning reader over a contiguous block of bytes.
+ *
+ * Exposes the subset of the std::istream interface used by the serialization
+ * templates so inbound packets can be decoded straight out of the network
+ * buffer without first being copied into a stringstream.
+ */
+class BufferReader {
+public:
+    BufferReader(const unsigned char* data, size_t length)
+        : data_{data}
+        , length_{length} {}
+
+    void read(char* dest, size_t count) {
+        require(count);
+        std::memcpy(dest, data_ + position_, count);
+        position_ += count;
+    }
+
+    void seekg(size_t position) {
+        if (position > length_) {
+            throw std::out_of_range{"Seek past the end of the buffer"};
+        }
+
+        position_ = position;
+    }
+
+    size_t tellg() const { return position_; }
+
+    /** Throws if fewer than count bytes remain to be read.
+     */
+    void require(size_t count) const {
+        if (count > length_ - position_) {
+            throw std::out_of_range{"Read past the end of the buffer"};
+        }
+    }
+
+    const unsigned char* data() const { return data_; }
+    size_t length() const { return length_; }
+    size_t remaining() const { return length_ - position_; }
+
+private:
+    const unsigned char* data_;
+    size_t length_;
+    size_t position_ = 0;
+};
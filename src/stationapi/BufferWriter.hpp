@@ -0,0 +1,42 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+/** A contiguous, growable output buffer.
+ *
+ * Exposes the write subset of the std::ostream interface used by the
+ * serialization templates. Clearing the buffer keeps its capacity so a single
+ * instance can be reused across many messages without reallocating.
+ */
+class BufferWriter {
+public:
+    BufferWriter() = default;
+    explicit BufferWriter(size_t reserve) { buffer_.reserve(reserve); }
+
+    void write(const char* data, size_t count) {
+        auto offset = buffer_.size();
+        buffer_.resize(offset + count);
+        std::memcpy(buffer_.data() + offset, data, count);
+    }
+
+    void clear() { buffer_.clear(); }
+
+    /** Releases excess memory when the buffer has grown beyond maxCapacity.
+     */
+    void shrink(size_t maxCapacity) {
+        if (buffer_.capacity() > maxCapacity) {
+            std::vector<unsigned char>{}.swap(buffer_);
+            buffer_.reserve(maxCapacity);
+        }
+    }
+
+    const unsigned char* data() const { return buffer_.data(); }
+    size_t length() const { return buffer_.size(); }
+    size_t capacity() const { return buffer_.capacity(); }
+
+private:
+    std::vector<unsigned char> buffer_;
+};
@@ -0,0 +1,64 @@
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/** An unbounded lock-free queue for many producers and a single consumer.
+ *
+ * Push may be called from any thread and never blocks. TryPop must only ever
+ * be called from one thread at a time.
+ */
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue()
+        : head_{new Node}
+        , tail_{head_.load()} {}
+
+    ~MpscQueue() {
+        T value;
+        while (TryPop(value)) {
+        }
+
+        delete tail_;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void Push(T value) {
+        auto node = new Node;
+        node->value = std::move(value);
+
+        auto prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool TryPop(T& value) {
+        auto tail = tail_;
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+
+        value = std::move(next->value);
+        tail_ = next;
+        delete tail;
+
+        return true;
+    }
+
+    /** Only meaningful on the consumer thread.
+     */
+    bool IsEmpty() const { return tail_->next.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node*> head_;
+    Node* tail_;
+};
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include "BufferPool.hpp"
 #include "UdpLibrary.hpp"
 
 #include <algorithm>
@@ -37,9 +38,20 @@ public:
 
     virtual ~Node() { udpManager_->Release(); }
 
-    void Tick()
+    /** Gives the udp library time to process the sockets and returns true if
+     * any packets or connection requests arrived while doing so.
+     */
+    bool Tick()
     {
+        auto activity = CountActivity();
         udpManager_->GiveTime();
+        bool active = CountActivity() != activity;
+
+        for (auto &client : clients_)
+        {
+            if (client->GetConnection()->GetStatus() == UdpConnection::cStatusDisconnected)
+                OnClientDisconnected(client.get());
+        }
 
         auto remove_iter = std::remove_if(std::begin(clients_), std::end(clients_), [](auto &client)
                                           { return client->GetConnection()->GetStatus() == UdpConnection::cStatusDisconnected; });
@@ -48,19 +60,38 @@ public:
             clients_.erase(remove_iter, clients_.end());
 
         OnTick();
+
+        return active;
     }
 
+    BufferPool& GetBufferPool() { return bufferPool_; }
+
 private:
     virtual void OnTick() = 0;
 
+    /** Called for each disconnected client just before it is destroyed. */
+    virtual void OnClientDisconnected(ClientT*) {}
+
+    uint64_t CountActivity() const
+    {
+        uint64_t activity = connectRequests_;
+        for (auto &client : clients_)
+            activity += client->GetPacketsReceived();
+
+        return activity;
+    }
+
     void OnConnectRequest(UdpConnection *connection) override
     {
+        ++connectRequests_;
         AddClient(std::make_unique<ClientT>(connection, node_));
     }
 
     void AddClient(std::unique_ptr<ClientT> client) { clients_.push_back(std::move(client)); }
 
+    BufferPool bufferPool_;
     std::vector<std::unique_ptr<ClientT>> clients_;
     NodeT *node_;
     UdpManager *udpManager_;
+    uint64_t connectRequests_ = 0;
 };
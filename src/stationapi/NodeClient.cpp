@@ -2,10 +2,11 @@
 #include "NodeClient.hpp"
 #include "StreamUtils.hpp"
 
-NodeClient::NodeClient(UdpConnection* connection)
-    : connection_{connection}
-    , ostream_{std::stringstream::out | std::stringstream::binary}
-    , istream_{std::stringstream::in | std::stringstream::binary} {
+#include "easylogging++.h"
+
+NodeClient::NodeClient(UdpConnection* connection, BufferPool& bufferPool)
+    : bufferPool_{bufferPool}
+    , connection_{connection} {
     connection_->AddRef();
 }
 
@@ -15,16 +16,20 @@ NodeClient::~NodeClient() {
     connection_->Release();
 }
 
-void NodeClient::Send(const char* data, uint32_t length) {
-    logNetworkMessage(
-        connection_, "Message To ->", reinterpret_cast<const unsigned char*>(data), length);
-    connection_->Send(cUdpChannelReliable1, data, length);
+void NodeClient::Send(const unsigned char* data, size_t length) {
+    logNetworkMessage(connection_, "Message To ->", data, static_cast<int>(length));
+    connection_->Send(cUdpChannelReliable1, data, static_cast<int>(length));
 }
 
 void NodeClient::OnRoutePacket(UdpConnection* connection, const uchar* data, int length) {
     logNetworkMessage(connection, "Message From <-", data, length);
+    ++packetsReceived_;
+
+    BufferReader istream{data, static_cast<size_t>(length)};
 
-    istream_.clear();
-    istream_.str({reinterpret_cast<const char*>(data), static_cast<uint32_t>(length)});
-    OnIncoming(istream_);
+    try {
+        OnIncoming(istream);
+    } catch (const std::out_of_range& e) {
+        LOG(ERROR) << "Dropping malformed packet of length " << length << ": " << e.what();
+    }
 }
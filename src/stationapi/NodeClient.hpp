@@ -1,35 +1,42 @@
 
 #pragma once
 
+#include "BufferPool.hpp"
+#include "BufferReader.hpp"
+#include "Serialization.hpp"
 #include "UdpLibrary.hpp"
 
-#include <sstream>
+#include <cstdint>
 
 class NodeClient : public UdpConnectionHandler {
 public:
-    explicit NodeClient(UdpConnection* connection);
+    NodeClient(UdpConnection* connection, BufferPool& bufferPool);
 
     virtual ~NodeClient();
 
     template <typename T>
     void Send(const T& message) {
-        ostream_.clear();
-        ostream_.str("");
-        write(ostream_, message);
-        auto data = ostream_.str();
-        Send(data.c_str(), data.length());
+        auto buffer = bufferPool_.Acquire();
+        write(*buffer, message);
+        Send(buffer->data(), buffer->length());
     }
 
+    /** Sends a message that has already been serialized, allowing a single
+     * encoding to be shared when fanning the same message out to many clients.
+     */
+    void SendEncoded(const BufferWriter& buffer) { Send(buffer.data(), buffer.length()); }
+
     UdpConnection* GetConnection() { return connection_; }
+    uint64_t GetPacketsReceived() const { return packetsReceived_; }
 
 private:
-    void Send(const char* data, uint32_t length);
+    void Send(const unsigned char* data, size_t length);
 
-    virtual void OnIncoming(std::istringstream& istream) = 0;
+    virtual void OnIncoming(BufferReader& istream) = 0;
 
     void OnRoutePacket(UdpConnection* connection, const uchar* data, int length) override;
 
-    std::ostringstream ostream_;
-    std::istringstream istream_;
+    BufferPool& bufferPool_;
     UdpConnection* connection_;
+    uint64_t packetsReceived_ = 0;
 };
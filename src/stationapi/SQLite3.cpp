@@ -0,0 +1,194 @@
+#include "SQLite3.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+
+SQLite3Statement::SQLite3Statement(sqlite3* db, const std::string& sql)
+    : db_{db} {
+    auto result = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt_, 0);
+    if (result != SQLITE_OK) {
+        sqlite3_finalize(stmt_);
+        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    }
+}
+
+SQLite3Statement::~SQLite3Statement() { sqlite3_finalize(stmt_); }
+
+void SQLite3Statement::BindInt(const char* name, int64_t value) {
+    sqlite3_bind_int64(stmt_, GetParameterIndex(name), value);
+}
+
+void SQLite3Statement::BindText(const char* name, const std::string& value) {
+    sqlite3_bind_text(stmt_, GetParameterIndex(name), value.c_str(), -1, SQLITE_TRANSIENT);
+}
+
+void SQLite3Statement::BindBlob(const char* name, const void* data, int size) {
+    sqlite3_bind_blob(stmt_, GetParameterIndex(name), data, size, SQLITE_TRANSIENT);
+}
+
+bool SQLite3Statement::Step() {
+    auto result = sqlite3_step(stmt_);
+    if (result == SQLITE_ROW) {
+        return true;
+    }
+
+    if (result != SQLITE_DONE) {
+        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    }
+
+    return false;
+}
+
+void SQLite3Statement::Execute() {
+    auto result = sqlite3_step(stmt_);
+    if (result != SQLITE_DONE) {
+        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    }
+}
+
+std::string SQLite3Statement::ColumnText(int column) const {
+    auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt_, column));
+    return text ? std::string{text} : std::string{};
+}
+
+void SQLite3Statement::Reset() {
+    sqlite3_reset(stmt_);
+    sqlite3_clear_bindings(stmt_);
+}
+
+int SQLite3Statement::GetParameterIndex(const char* name) {
+    auto find_iter = parameterIndexes_.find(name);
+    if (find_iter != std::end(parameterIndexes_)) {
+        return find_iter->second;
+    }
+
+    int index = sqlite3_bind_parameter_index(stmt_, name);
+    if (index == 0) {
+        throw SQLite3Exception{SQLITE_RANGE, std::string{"Unknown statement parameter "} + name};
+    }
+
+    parameterIndexes_.emplace(name, index);
+    return index;
+}
+
+SQLite3StatementCache::Lease SQLite3StatementCache::Prepare(const std::string& sql) {
+    auto find_iter = statements_.find(sql);
+    if (find_iter == std::end(statements_)) {
+        CachedStatement cached;
+        cached.statement = std::make_unique<SQLite3Statement>(db_, sql);
+        find_iter = statements_.emplace(sql, std::move(cached)).first;
+    } else if (find_iter->second.leased) {
+        return Lease{std::make_unique<SQLite3Statement>(db_, sql)};
+    }
+
+    return Lease{&find_iter->second};
+}
+
+namespace {
+
+void ExecutePragma(sqlite3* db, const std::string& pragma) {
+    char* error = nullptr;
+    auto result = sqlite3_exec(db, ("PRAGMA " + pragma).c_str(), nullptr, nullptr, &error);
+    if (result != SQLITE_OK) {
+        std::string message = error ? error : sqlite3_errmsg(db);
+        sqlite3_free(error);
+        throw SQLite3Exception{result, message};
+    }
+}
+
+std::string QueryPragma(sqlite3* db, const std::string& pragma) {
+    SQLite3Statement stmt{db, "PRAGMA " + pragma};
+    return stmt.Step() ? stmt.ColumnText(0) : std::string{};
+}
+
+// Keyword valued pragmas are spliced into the statement text, so only the
+// values SQLite documents are let through.
+const std::string& CheckKeyword(const char* pragma, const std::string& value,
+    std::initializer_list<const char*> allowed) {
+    for (auto keyword : allowed) {
+        if (sqlite3_stricmp(value.c_str(), keyword) == 0) {
+            return value;
+        }
+    }
+
+    throw SQLite3Exception{SQLITE_MISUSE, std::string{"Invalid "} + pragma + " setting: " + value};
+}
+
+const char* KeywordAt(int index, std::initializer_list<const char*> keywords) {
+    return index >= 0 && static_cast<size_t>(index) < keywords.size() ? keywords.begin()[index] : "unknown";
+}
+
+} // namespace
+
+void ApplySQLite3Settings(sqlite3* db, const SQLite3Settings& settings) {
+    // Set first so switching the journal mode waits out other connections.
+    sqlite3_busy_timeout(db, settings.busyTimeout);
+
+    ExecutePragma(db, "journal_mode = " + CheckKeyword("journal_mode", settings.journalMode,
+        {"delete", "truncate", "persist", "memory", "wal", "off"}));
+    ExecutePragma(db, "synchronous = " + CheckKeyword("synchronous", settings.synchronous,
+        {"off", "normal", "full", "extra"}));
+    ExecutePragma(db, "cache_size = " + std::to_string(settings.cacheSize));
+    ExecutePragma(db, "mmap_size = " + std::to_string(settings.mmapSize));
+    ExecutePragma(db, "temp_store = " + CheckKeyword("temp_store", settings.tempStore,
+        {"default", "file", "memory"}));
+}
+
+std::string DescribeSQLite3Settings(sqlite3* db) {
+    return "journal_mode=" + QueryPragma(db, "journal_mode")
+        + " synchronous=" + KeywordAt(std::stoi(QueryPragma(db, "synchronous")), {"off", "normal", "full", "extra"})
+        + " cache_size=" + QueryPragma(db, "cache_size")
+        + " mmap_size=" + QueryPragma(db, "mmap_size")
+        + " busy_timeout=" + QueryPragma(db, "busy_timeout")
+        + " temp_store=" + KeywordAt(std::stoi(QueryPragma(db, "temp_store")), {"default", "file", "memory"});
+}
+
+int GetSQLite3UserVersion(sqlite3* db) {
+    return std::stoi(QueryPragma(db, "user_version"));
+}
+
+int MigrateSQLite3Database(sqlite3* db, const std::vector<SQLite3Migration>& migrations) {
+    auto ordered = migrations;
+    std::sort(std::begin(ordered), std::end(ordered),
+        [](const SQLite3Migration& lhs, const SQLite3Migration& rhs) { return lhs.version < rhs.version; });
+
+    int currentVersion = GetSQLite3UserVersion(db);
+    int latestVersion = ordered.empty() ? 0 : ordered.back().version;
+
+    if (currentVersion > latestVersion) {
+        throw SQLite3Exception{SQLITE_MISMATCH, "Database schema version " + std::to_string(currentVersion)
+            + " is newer than the latest known version " + std::to_string(latestVersion)};
+    }
+
+    int applied = 0;
+    for (auto& migration : ordered) {
+        if (migration.version <= currentVersion) {
+            continue;
+        }
+
+        auto result = sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr);
+        if (result != SQLITE_OK) {
+            throw SQLite3Exception{result, sqlite3_errmsg(db)};
+        }
+
+        char* error = nullptr;
+        auto sql = std::string{migration.sql} + ";PRAGMA user_version = " + std::to_string(migration.version);
+        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error);
+        if (result == SQLITE_OK) {
+            result = sqlite3_exec(db, "COMMIT", nullptr, nullptr, &error);
+        }
+
+        if (result != SQLITE_OK) {
+            std::string message = std::string{"Migration to version "} + std::to_string(migration.version) + " ("
+                + migration.description + ") failed: " + (error ? error : sqlite3_errmsg(db));
+            sqlite3_free(error);
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+            throw SQLite3Exception{result, message};
+        }
+
+        currentVersion = migration.version;
+        ++applied;
+    }
+
+    return applied;
+}
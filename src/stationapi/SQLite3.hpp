@@ -0,0 +1,181 @@
+
+#pragma once
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SQLite3Exception : public std::runtime_error {
+public:
+    SQLite3Exception(int code, const std::string& message)
+        : std::runtime_error{message}
+        , code{code} {}
+
+    int code;
+};
+
+/** Connection tuning applied through PRAGMAs when a database is opened.
+ *
+ * Values use SQLite's own spelling: cacheSize counts pages, or KiB when
+ * negative, mmapSize is in bytes and busyTimeout in milliseconds.
+ */
+struct SQLite3Settings {
+    std::string journalMode = "delete";
+    std::string synchronous = "full";
+    int64_t cacheSize = -16384;
+    int64_t mmapSize = 0;
+    int busyTimeout = 5000;
+    std::string tempStore = "default";
+};
+
+/** Applies the settings to an open connection.
+ *
+ * Throws SQLite3Exception if a setting has an unknown value or SQLite
+ * rejects it.
+ */
+void ApplySQLite3Settings(sqlite3* db, const SQLite3Settings& settings);
+
+/** Reads back the settings in effect on a connection, for logging.
+ */
+std::string DescribeSQLite3Settings(sqlite3* db);
+
+/** One step of a schema upgrade, tagged with the version it brings the
+ * database to.
+ */
+struct SQLite3Migration {
+    int version;
+    const char* description;
+    const char* sql;
+};
+
+/** Brings a database up to the newest migration, tracking progress in
+ * PRAGMA user_version.
+ *
+ * Pending migrations run in version order, each in its own transaction along
+ * with the user_version bump, so an interrupted upgrade resumes at the first
+ * step that did not complete. Returns the number of migrations applied.
+ * Throws SQLite3Exception if a migration fails or the database is already
+ * newer than the newest migration.
+ */
+int MigrateSQLite3Database(sqlite3* db, const std::vector<SQLite3Migration>& migrations);
+
+/** Returns the schema version recorded in PRAGMA user_version.
+ */
+int GetSQLite3UserVersion(sqlite3* db);
+
+/** A prepared statement that is compiled once and reused.
+ *
+ * Parameter indexes are looked up by name the first time they are bound and
+ * cached for later executions. Text and blob values are bound with
+ * SQLITE_TRANSIENT so callers may pass temporaries.
+ */
+class SQLite3Statement {
+public:
+    SQLite3Statement(sqlite3* db, const std::string& sql);
+    ~SQLite3Statement();
+
+    SQLite3Statement(const SQLite3Statement&) = delete;
+    SQLite3Statement& operator=(const SQLite3Statement&) = delete;
+
+    void BindInt(const char* name, int64_t value);
+    void BindText(const char* name, const std::string& value);
+    void BindBlob(const char* name, const void* data, int size);
+
+    /** Steps the statement, returning true while rows are available.
+     *
+     * Throws SQLite3Exception on anything other than SQLITE_ROW or SQLITE_DONE.
+     */
+    bool Step();
+
+    /** Steps a statement that is not expected to return rows.
+     */
+    void Execute();
+
+    int ColumnInt(int column) const { return sqlite3_column_int(stmt_, column); }
+    std::string ColumnText(int column) const;
+    const void* ColumnBlob(int column) const { return sqlite3_column_blob(stmt_, column); }
+    int ColumnBytes(int column) const { return sqlite3_column_bytes(stmt_, column); }
+
+    void Reset();
+
+    sqlite3_stmt* get() { return stmt_; }
+
+private:
+    int GetParameterIndex(const char* name);
+
+    sqlite3* db_;
+    sqlite3_stmt* stmt_ = nullptr;
+    std::unordered_map<std::string, int> parameterIndexes_;
+};
+
+/** Prepares each distinct SQL text once per connection.
+ *
+ * Statements are handed out as leases which reset the statement and clear
+ * its bindings when they go out of scope, including when a query throws.
+ * Preparing a statement that is already leased, for instance while stepping
+ * through its results, hands out a separate statement that is finalized when
+ * its lease ends rather than the cached one.
+ */
+class SQLite3StatementCache {
+    struct CachedStatement {
+        std::unique_ptr<SQLite3Statement> statement;
+        bool leased = false;
+    };
+
+public:
+    class Lease {
+    public:
+        explicit Lease(CachedStatement* cached)
+            : statement_{cached->statement.get()}
+            , leased_{&cached->leased} {
+            *leased_ = true;
+        }
+
+        explicit Lease(std::unique_ptr<SQLite3Statement> statement)
+            : statement_{statement.get()}
+            , owned_{std::move(statement)} {}
+
+        Lease(Lease&& other)
+            : statement_{other.statement_}
+            , leased_{other.leased_}
+            , owned_{std::move(other.owned_)} {
+            other.statement_ = nullptr;
+            other.leased_ = nullptr;
+        }
+
+        ~Lease() {
+            if (leased_) {
+                statement_->Reset();
+                *leased_ = false;
+            }
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        SQLite3Statement& operator*() { return *statement_; }
+        SQLite3Statement* operator->() { return statement_; }
+
+    private:
+        SQLite3Statement* statement_;
+        bool* leased_ = nullptr;
+        std::unique_ptr<SQLite3Statement> owned_;
+    };
+
+    explicit SQLite3StatementCache(sqlite3* db)
+        : db_{db} {}
+
+    Lease Prepare(const std::string& sql);
+
+    size_t GetPreparedCount() const { return statements_.size(); }
+
+private:
+    sqlite3* db_;
+    std::unordered_map<std::string, CachedStatement> statements_;
+};
@@ -1,9 +1,21 @@
 
 #pragma once
 
+#include "BufferReader.hpp"
+
 #include <string>
 #include <type_traits>
 
+// Length prefixes are validated against the remaining input when the stream is
+// able to report it, generic streams simply fail the subsequent read.
+
+template <typename StreamT>
+void ensureReadable(StreamT&, size_t) {}
+
+inline void ensureReadable(BufferReader& istream, size_t count) {
+    istream.require(count);
+}
+
 // integral types
 
 template <typename StreamT, typename T,
@@ -53,6 +65,7 @@ template <typename StreamT>
 void read(StreamT& istream, std::string& value) {
     uint16_t length;
     read(istream, length);
+    ensureReadable(istream, length);
 
     value.resize(length);
 
@@ -73,12 +86,11 @@ template <typename StreamT>
 void read(StreamT& istream, std::u16string& value) {
     uint32_t length;
     read(istream, length);
+    ensureReadable(istream, static_cast<size_t>(length) * sizeof(uint16_t));
 
     value.resize(length);
-    uint16_t tmp;
-    for (uint32_t i = 0; i < length; ++i) {
-        istream.read(reinterpret_cast<char*>(&tmp), sizeof(uint16_t));
-        value[i] = tmp;
+    if (length > 0) {
+        istream.read(reinterpret_cast<char*>(&value[0]), length * sizeof(uint16_t));
     }
 }
 
@@ -87,11 +99,7 @@ void write(StreamT& ostream, const std::u16string& value) {
     uint32_t length = static_cast<uint32_t>(value.length());
     write(ostream, length);
 
-    uint16_t tmp;
-    for (uint32_t i = 0; i < length; ++i) {
-        tmp = static_cast<uint16_t>(value[i]);
-        ostream.write(reinterpret_cast<const char*>(&tmp), sizeof(uint16_t));
-    }
+    ostream.write(reinterpret_cast<const char*>(value.data()), length * sizeof(uint16_t));
 }
 
 // Specialized Read Types
@@ -0,0 +1,65 @@
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/** Hands out fixed size blocks for objects of type T carved from large slabs.
+ *
+ * Freed blocks are threaded onto a free list and reused before a new slab is
+ * allocated, so many long lived objects share a few large allocations instead
+ * of paying the general purpose allocator's per-allocation overhead. Slabs are
+ * only released when the allocator is destroyed. Not thread safe.
+ */
+template <typename T, size_t BlocksPerSlab = 1024>
+class SlabAllocator {
+public:
+    SlabAllocator() = default;
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    void* Allocate() {
+        if (!free_) {
+            AddSlab();
+        }
+
+        auto block = free_;
+        free_ = block->next;
+        ++allocated_;
+
+        return block;
+    }
+
+    void Deallocate(void* ptr) {
+        auto block = static_cast<Block*>(ptr);
+        block->next = free_;
+        free_ = block;
+        --allocated_;
+    }
+
+    size_t GetAllocatedCount() const { return allocated_; }
+    size_t GetSlabCount() const { return slabs_.size(); }
+
+private:
+    union Block {
+        Block* next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    void AddSlab() {
+        slabs_.emplace_back(new Block[BlocksPerSlab]);
+        auto slab = slabs_.back().get();
+
+        for (size_t i = 0; i < BlocksPerSlab; ++i) {
+            slab[i].next = free_;
+            free_ = &slab[i];
+        }
+    }
+
+    std::vector<std::unique_ptr<Block[]>> slabs_;
+    Block* free_ = nullptr;
+    size_t allocated_ = 0;
+};
@@ -1,9 +1,14 @@
 #include "ChatAvatar.hpp"
 #include "ChatAvatarService.hpp"
 #include "ChatRoom.hpp"
+#include "SlabAllocator.hpp"
 
 #include <algorithm>
 
+namespace {
+SlabAllocator<ChatAvatar> avatarAllocator;
+}
+
 ChatAvatar::ChatAvatar(ChatAvatarService * avatarService)
     : avatarService_{avatarService} {}
 
@@ -12,9 +17,68 @@ ChatAvatar::ChatAvatar(ChatAvatarService* avatarService, const std::u16string& n
     : avatarService_{avatarService}
     , userId_{userId}
     , name_{name}
-    , address_{address}
-    , attributes_{attributes}
-    , loginLocation_{loginLocation} {}
+    , addressAtom_{avatarService->GetAddressTable()->Intern(address)}
+    , attributes_{attributes} {
+    if (!loginLocation.empty()) {
+        GetDetails().loginLocation = loginLocation;
+    }
+}
+
+void* ChatAvatar::operator new(size_t size) {
+    if (size != sizeof(ChatAvatar)) {
+        return ::operator new(size);
+    }
+
+    return avatarAllocator.Allocate();
+}
+
+void ChatAvatar::operator delete(void* ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+
+    if (size != sizeof(ChatAvatar)) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    avatarAllocator.Deallocate(ptr);
+}
+
+const std::u16string& ChatAvatar::EmptyString() {
+    static const std::u16string empty;
+    return empty;
+}
+
+const std::u16string& ChatAvatar::GetAddress() const {
+    return avatarService_->GetAddressTable()->GetAddress(addressAtom_);
+}
+
+ChatAvatar::Details& ChatAvatar::GetDetails() {
+    if (!details_) {
+        details_ = std::make_unique<Details>();
+    }
+
+    return *details_;
+}
+
+ChatAvatar::Contacts& ChatAvatar::GetContacts() {
+    if (!contacts_) {
+        contacts_ = std::make_unique<Contacts>();
+    }
+
+    return *contacts_;
+}
+
+const std::vector<FriendContact>& ChatAvatar::GetFriendList() const {
+    static const std::vector<FriendContact> empty;
+    return contacts_ ? contacts_->friendList : empty;
+}
+
+const std::vector<IgnoreContact>& ChatAvatar::GetIgnoreList() const {
+    static const std::vector<IgnoreContact> empty;
+    return contacts_ ? contacts_->ignoreList : empty;
+}
 
 void ChatAvatar::SetAttributes(const uint32_t attributes) { attributes_ = attributes; }
 
@@ -22,70 +86,64 @@ void ChatAvatar::AddFriend(ChatAvatar* avatar, const std::u16string& comment) {
     if (IsFriend(avatar)) return;    
     if (IsIgnored(avatar)) RemoveIgnore(avatar);
 
-    friendList_.push_back(FriendContact{avatar, comment});
+    auto& contacts = GetContacts();
+    contacts.friendList.push_back(FriendContact{avatar->avatarId_, comment});
+    contacts.friendIds.insert(avatar->avatarId_);
+    avatarService_->IndexFriend(avatarId_, avatar->avatarId_);
 
     avatarService_->PersistFriend(avatarId_, avatar->avatarId_, comment);
 }
 
 void ChatAvatar::RemoveFriend(const ChatAvatar* avatar) {
-    auto del_iter = std::remove_if(std::begin(friendList_), std::end(friendList_),
-        [avatar](auto& frnd) { return frnd.frnd->GetAvatarId() == avatar->GetAvatarId(); });
+    if (!contacts_) return;
+
+    auto del_iter = std::remove_if(std::begin(contacts_->friendList), std::end(contacts_->friendList),
+        [avatar](auto& frnd) { return frnd.frndId == avatar->GetAvatarId(); });
 
-    if (del_iter != std::end(friendList_)) {
-        friendList_.erase(del_iter);
+    if (del_iter != std::end(contacts_->friendList)) {
+        contacts_->friendList.erase(del_iter);
+        contacts_->friendIds.erase(avatar->avatarId_);
+        avatarService_->UnindexFriend(avatarId_, avatar->avatarId_);
 
         avatarService_->RemoveFriend(avatarId_, avatar->avatarId_);
     }
 }
 
 void ChatAvatar::UpdateFriendComment(const ChatAvatar* avatar, const std::u16string& comment) {
-    auto find_iter = std::find_if(std::begin(friendList_), std::end(friendList_),
-        [avatar](auto& frnd) { return frnd.frnd->GetAvatarId() == avatar->GetAvatarId(); });
+    if (!contacts_) return;
 
-    if (find_iter != std::end(friendList_)) {
+    auto find_iter = std::find_if(std::begin(contacts_->friendList), std::end(contacts_->friendList),
+        [avatar](auto& frnd) { return frnd.frndId == avatar->GetAvatarId(); });
+
+    if (find_iter != std::end(contacts_->friendList)) {
         find_iter->comment = comment;
         avatarService_->UpdateFriendComment(avatarId_, avatar->avatarId_, comment);
     }
 }
 
-bool ChatAvatar::IsFriend(const ChatAvatar* avatar) {
-    auto find_iter = std::find_if(std::begin(friendList_), std::end(friendList_),
-        [avatar](auto& frnd) { return frnd.frnd->GetAvatarId() == avatar->GetAvatarId(); });
-
-    if (find_iter != std::end(friendList_)) {
-        return true;
-    }
-
-    return false;
-}
-
 void ChatAvatar::AddIgnore(ChatAvatar* avatar) {
     if (IsIgnored(avatar)) return;
     if (IsFriend(avatar)) RemoveFriend(avatar);
 
-    ignoreList_.push_back(IgnoreContact{avatar});
+    auto& contacts = GetContacts();
+    contacts.ignoreList.push_back(IgnoreContact{avatar->avatarId_});
+    contacts.ignoreIds.insert(avatar->avatarId_);
+    avatarService_->IndexIgnore(avatarId_, avatar->avatarId_);
 
     avatarService_->PersistIgnore(avatarId_, avatar->avatarId_);
 }
 
 void ChatAvatar::RemoveIgnore(const ChatAvatar* avatar) {
-    auto del_iter = std::remove_if(std::begin(ignoreList_), std::end(ignoreList_),
-        [avatar](auto& ignored) { return ignored.ignored->GetAvatarId() == avatar->GetAvatarId(); });
-
-    if (del_iter != std::end(ignoreList_)) {
-        ignoreList_.erase(del_iter);
+    if (!contacts_) return;
 
-        avatarService_->RemoveIgnore(avatarId_, avatar->avatarId_);
-    }
-}
+    auto del_iter = std::remove_if(std::begin(contacts_->ignoreList), std::end(contacts_->ignoreList),
+        [avatar](auto& ignored) { return ignored.ignoredId == avatar->GetAvatarId(); });
 
-bool ChatAvatar::IsIgnored(const ChatAvatar* avatar) {
-    auto find_iter = std::find_if(std::begin(ignoreList_), std::end(ignoreList_),
-                                  [avatar](auto& ignored) { return ignored.ignored->GetAvatarId() == avatar->GetAvatarId(); });
+    if (del_iter != std::end(contacts_->ignoreList)) {
+        contacts_->ignoreList.erase(del_iter);
+        contacts_->ignoreIds.erase(avatar->avatarId_);
+        avatarService_->UnindexIgnore(avatarId_, avatar->avatarId_);
 
-    if (find_iter != std::end(ignoreList_)) {
-        return true;
+        avatarService_->RemoveIgnore(avatarId_, avatar->avatarId_);
     }
-
-    return false;
 }
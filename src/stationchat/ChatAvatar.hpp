@@ -1,10 +1,13 @@
 
 #pragma once
 
+#include "AddressTable.hpp"
 #include "Serialization.hpp"
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 class ChatAvatar;
@@ -19,20 +22,24 @@ enum class AvatarAttribute : uint32_t {
     EXTENDED = 1 << 4
 };
 
+/** Contacts refer to avatars by id and are resolved through the
+ * ChatAvatarService only when needed, so loading an avatar does not pull in
+ * the avatars on its lists.
+ */
 struct FriendContact {
-    FriendContact(const ChatAvatar* frnd_, const std::u16string& comment_)
-            : frnd{frnd_}
+    FriendContact(uint32_t frndId_, const std::u16string& comment_)
+            : frndId{frndId_}
             , comment{comment_} {}
 
-    const ChatAvatar* frnd;
+    uint32_t frndId;
     std::u16string comment = u"";
 };
 
 struct IgnoreContact {
-    IgnoreContact(const ChatAvatar* ignored_)
-            : ignored{ignored_} {}
+    IgnoreContact(uint32_t ignoredId_)
+            : ignoredId{ignoredId_} {}
 
-    const ChatAvatar* ignored;
+    uint32_t ignoredId;
 };
 
 class ChatAvatar {
@@ -49,56 +56,83 @@ public:
     const uint32_t GetAvatarId() const { return avatarId_; }
     const uint32_t GetUserId() const { return userId_; }
     const std::u16string& GetName() const { return name_; }
-    const std::u16string& GetAddress() const { return address_; }
+    const std::u16string& GetAddress() const;
+    AddressAtom GetAddressAtom() const { return addressAtom_; }
     const uint32_t GetAttributes() const { return attributes_; }
     void SetAttributes(const uint32_t attributes);
-    const std::u16string& GetLoginLocation() const { return loginLocation_; }
-    const std::u16string& GetServer() const { return server_; }
-    const std::u16string& GetGateway() const { return gateway_; }
-    const uint32_t GetServerId() const { return serverId_; }
-    const uint32_t GetGatewayId() const { return gatewayId_; }
-    const std::u16string& GetEmail() const { return email_; }
-    const uint32_t GetInboxLimit() const { return inboxLimit_; }
-    const std::u16string& GetStatusMessage() const { return statusMessage_; }
+    const std::u16string& GetLoginLocation() const { return details_ ? details_->loginLocation : EmptyString(); }
+    const std::u16string& GetServer() const { return details_ ? details_->server : EmptyString(); }
+    const std::u16string& GetGateway() const { return details_ ? details_->gateway : EmptyString(); }
+    const uint32_t GetServerId() const { return details_ ? details_->serverId : 0; }
+    const uint32_t GetGatewayId() const { return details_ ? details_->gatewayId : 0; }
+    const std::u16string& GetEmail() const { return details_ ? details_->email : EmptyString(); }
+    const uint32_t GetInboxLimit() const { return details_ ? details_->inboxLimit : 0; }
+    const std::u16string& GetStatusMessage() const { return details_ ? details_->statusMessage : EmptyString(); }
     const bool IsOnline() const { return isOnline_; }
 
     void AddFriend(ChatAvatar* avatar, const std::u16string& comment = u"");
     void RemoveFriend(const ChatAvatar* avatar);
     void UpdateFriendComment(const ChatAvatar* avatar, const std::u16string& comment);
-    bool IsFriend(const ChatAvatar* avatar);
+    bool IsFriend(const ChatAvatar* avatar) const { return IsFriend(avatar->GetAvatarId()); }
+    bool IsFriend(uint32_t avatarId) const { return contacts_ && contacts_->friendIds.count(avatarId) != 0; }
 
-    const std::vector<FriendContact> GetFriendList() const { return friendList_; }
+    const std::vector<FriendContact>& GetFriendList() const;
 
     void AddIgnore(ChatAvatar* avatar);
     void RemoveIgnore(const ChatAvatar* avatar);
-    bool IsIgnored(const ChatAvatar* avatar);
+    bool IsIgnored(const ChatAvatar* avatar) const { return IsIgnored(avatar->GetAvatarId()); }
+    bool IsIgnored(uint32_t avatarId) const { return contacts_ && contacts_->ignoreIds.count(avatarId) != 0; }
 
-    const std::vector<IgnoreContact> GetIgnoreList() const { return ignoreList_; }
+    const std::vector<IgnoreContact>& GetIgnoreList() const;
+
+    /** Avatars are allocated from a shared slab to avoid a heap allocation
+     * and its bookkeeping per resident avatar.
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
 
 private:
     friend class ChatAvatarService;
 
+    /** Fields that are empty for nearly every avatar, allocated on first use.
+    */
+    struct Details {
+        std::u16string loginLocation;
+        std::u16string server;
+        std::u16string gateway;
+        std::u16string email;
+        std::u16string statusMessage;
+        uint32_t serverId = 0;
+        uint32_t gatewayId = 0;
+        uint32_t inboxLimit = 0;
+    };
+
+    /** Friend and ignore lists, allocated when the first contact is added.
+    */
+    struct Contacts {
+        std::vector<FriendContact> friendList;
+        std::vector<IgnoreContact> ignoreList;
+
+        // Hashed membership of the contact lists for constant time checks.
+        std::unordered_set<uint32_t> friendIds;
+        std::unordered_set<uint32_t> ignoreIds;
+    };
+
+    static const std::u16string& EmptyString();
+    Details& GetDetails();
+    Contacts& GetContacts();
+
     ChatAvatarService* avatarService_;
 
     uint32_t avatarId_ = 0;
     uint32_t userId_ = 0;
     std::u16string name_ = u"";
-    std::u16string address_ = u"";
+    AddressAtom addressAtom_ = NULL_ADDRESS_ATOM;
     uint32_t attributes_ = 0;
-    std::u16string loginLocation_ = u"";
-    std::u16string server_ = u"";
-    std::u16string gateway_ = u"";
-    uint32_t serverId_ = 0;
-    uint32_t gatewayId_ = 0;
-    std::u16string email_ = u"";
-    uint32_t inboxLimit_ = 0;
-    std::u16string statusMessage_ = u"";
     bool isOnline_ = false;
 
-    std::vector<FriendContact> friendList_;
-    std::vector<IgnoreContact> ignoreList_;
-
-    std::vector<ChatRoom*> rooms_;
+    std::unique_ptr<Details> details_;
+    std::unique_ptr<Contacts> contacts_;
 };
 
 template <typename StreamT>
@@ -115,17 +149,3 @@ void write(StreamT& ar, const ChatAvatar* data) {
     write(ar, data->GetGatewayId());
 }
 
-
-template <typename StreamT>
-void write(StreamT& ar, const FriendContact& data) {
-    write(ar, data.frnd->GetName());
-    write(ar, data.frnd->GetAddress());
-    write(ar, data.comment);
-    write(ar, static_cast<short>(data.frnd->IsOnline() ? 1 : 0));
-}
-
-template <typename StreamT>
-void write(StreamT& ar, const IgnoreContact& data) {
-    write(ar, data.ignored->GetName());
-    write(ar, data.ignored->GetAddress());
-}
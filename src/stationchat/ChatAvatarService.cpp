@@ -1,23 +1,33 @@
 #include "ChatAvatarService.hpp"
 #include "ChatAvatar.hpp"
-#include "SQLite3.hpp"
 #include "StringUtils.hpp"
 
 #include <easylogging++.h>
 
-ChatAvatarService::ChatAvatarService(sqlite3* db)
-    : db_{db} {}
+#include <chrono>
+
+namespace {
+const size_t MAX_EVICTION_SCAN = 1024;
+}
+
+ChatAvatarService::ChatAvatarService(AddressTable* addressTable, AvatarStore* avatarStore, ContactStore* contactStore)
+    : addressTable_{addressTable}
+    , avatarStore_{avatarStore}
+    , contactStore_{contactStore} {}
 
 ChatAvatarService::~ChatAvatarService() {}
 
 ChatAvatar* ChatAvatarService::GetAvatar(const std::u16string& name, const std::u16string& address) {
     ChatAvatar* avatar = GetCachedAvatar(name, address);
 
-    if (!avatar) {
-        auto loadedAvatar = LoadStoredAvatar(name, address);
+    if (avatar) {
+        ++cacheHits_;
+        TouchCachedAvatar(avatar->avatarId_);
+    } else {
+        ++cacheMisses_;
+        auto loadedAvatar = LoadStoredAvatar(avatarStore_->LoadAvatar(name, address));
         if (loadedAvatar != nullptr) {
-            avatar = loadedAvatar.get();
-            avatarCache_.emplace_back(std::move(loadedAvatar));
+            avatar = CacheAvatar(std::move(loadedAvatar));
 
             LoadFriendList(avatar);
             LoadIgnoreList(avatar);
@@ -30,11 +40,14 @@ ChatAvatar* ChatAvatarService::GetAvatar(const std::u16string& name, const std::
 ChatAvatar* ChatAvatarService::GetAvatar(uint32_t avatarId) {
     ChatAvatar* avatar = GetCachedAvatar(avatarId);
 
-    if (!avatar) {
-        auto loadedAvatar = LoadStoredAvatar(avatarId);
+    if (avatar) {
+        ++cacheHits_;
+        TouchCachedAvatar(avatarId);
+    } else {
+        ++cacheMisses_;
+        auto loadedAvatar = LoadStoredAvatar(avatarStore_->LoadAvatar(avatarId));
         if (loadedAvatar != nullptr) {
-            avatar = loadedAvatar.get();
-            avatarCache_.emplace_back(std::move(loadedAvatar));
+            avatar = CacheAvatar(std::move(loadedAvatar));
 
             LoadFriendList(avatar);
             LoadIgnoreList(avatar);
@@ -44,22 +57,107 @@ ChatAvatar* ChatAvatarService::GetAvatar(uint32_t avatarId) {
     return avatar;
 }
 
+void ChatAvatarService::WarmLoadAvatars() {
+    auto start = std::chrono::steady_clock::now();
+
+    size_t friendCount = 0;
+    size_t ignoreCount = 0;
+
+    avatarStore_->ForEachAvatar([this](const AvatarRecord& record) {
+        if (!GetCachedAvatar(record.avatarId)) {
+            CacheAvatar(LoadStoredAvatar(record));
+        }
+    });
+
+    contactStore_->ForEachFriend([this, &friendCount](const FriendRecord& record) {
+        auto avatar = GetCachedAvatar(record.avatarId);
+        auto friendId = record.friendAvatarId;
+        if (!avatar || avatar->IsFriend(friendId)) {
+            return;
+        }
+
+        auto& contacts = avatar->GetContacts();
+        contacts.friendList.emplace_back(friendId, record.comment);
+        contacts.friendIds.insert(friendId);
+        IndexFriend(avatar->avatarId_, friendId);
+        ++friendCount;
+    });
+
+    contactStore_->ForEachIgnore([this, &ignoreCount](const IgnoreRecord& record) {
+        auto avatar = GetCachedAvatar(record.avatarId);
+        auto ignoreId = record.ignoreAvatarId;
+        if (!avatar || avatar->IsIgnored(ignoreId)) {
+            return;
+        }
+
+        auto& contacts = avatar->GetContacts();
+        contacts.ignoreList.emplace_back(ignoreId);
+        contacts.ignoreIds.insert(ignoreId);
+        IndexIgnore(avatar->avatarId_, ignoreId);
+        ++ignoreCount;
+    });
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    LOG(INFO) << "Warm loaded " << avatarCache_.size() << " avatars, " << friendCount << " friends and "
+              << ignoreCount << " ignores in " << elapsed.count() << "ms (approx. "
+              << EstimateCacheMemory() / 1024 << " KB)";
+}
+
+size_t ChatAvatarService::EstimateCacheMemory() const {
+    // Rough accounting of the avatar cache: the objects and their strings, the
+    // contact lists and sets, and one hash node per index entry.
+    const size_t hashNodeSize = 2 * sizeof(void*) + sizeof(uint32_t);
+    size_t bytes = 0;
+
+    for (auto& entry : avatarCache_) {
+        auto avatar = entry.second.get();
+        bytes += sizeof(ChatAvatar) + 2 * hashNodeSize;
+        bytes += avatar->name_.capacity() * sizeof(char16_t);
+
+        if (avatar->details_) {
+            bytes += sizeof(ChatAvatar::Details);
+        }
+
+        if (avatar->contacts_) {
+            auto& contacts = *avatar->contacts_;
+            bytes += sizeof(ChatAvatar::Contacts);
+            bytes += contacts.friendList.capacity() * sizeof(FriendContact);
+            bytes += contacts.ignoreList.capacity() * sizeof(IgnoreContact);
+            bytes += (contacts.friendIds.size() + contacts.ignoreIds.size()) * hashNodeSize;
+
+            for (auto& contact : contacts.friendList) {
+                bytes += contact.comment.capacity() * sizeof(char16_t);
+            }
+        }
+    }
+
+    for (auto& entry : friendedBy_) {
+        bytes += hashNodeSize + entry.second.size() * hashNodeSize;
+    }
+
+    for (auto& entry : ignoredBy_) {
+        bytes += hashNodeSize + entry.second.size() * hashNodeSize;
+    }
+
+    return bytes;
+}
+
 ChatAvatar* ChatAvatarService::CreateAvatar(const std::u16string& name, const std::u16string& address,
     uint32_t userId, uint32_t loginAttributes, const std::u16string& loginLocation) {
     auto tmp
         = std::make_unique<ChatAvatar>(this, name, address, userId, loginAttributes, loginLocation);
-    auto avatar = tmp.get();
-
-    InsertAvatar(avatar);
 
-    avatarCache_.emplace_back(std::move(tmp));
+    tmp->avatarId_ = avatarStore_->InsertAvatar(ToRecord(tmp.get()));
 
-    return avatar;
+    return CacheAvatar(std::move(tmp));
 }
 
 void ChatAvatarService::DestroyAvatar(ChatAvatar* avatar) {
-    DeleteAvatar(avatar);
+    avatarStore_->DeleteAvatar(avatar->GetAvatarId());
     LogoutAvatar(avatar);
+    RemoveAsFriendOrIgnoreFromAll(avatar);
     RemoveCachedAvatar(avatar->GetAvatarId());
 }
 
@@ -67,6 +165,7 @@ void ChatAvatarService::LoginAvatar(ChatAvatar* avatar) {
     avatar->isOnline_ = true;
 
     if (!IsOnline(avatar)) {
+        onlineIndex_[avatar->GetAvatarId()] = onlineAvatars_.size();
         onlineAvatars_.push_back(avatar);
     }
 }
@@ -75,415 +174,322 @@ void ChatAvatarService::LogoutAvatar(ChatAvatar* avatar) {
 	if(!avatar->isOnline_) return;
     avatar->isOnline_ = false;
 
-    onlineAvatars_.erase(std::remove_if(
-        std::begin(onlineAvatars_), std::end(onlineAvatars_), [avatar](auto onlineAvatar) {
-            return onlineAvatar->GetAvatarId() == avatar->GetAvatarId();
-        }));
-}
-
-void ChatAvatarService::PersistAvatar(const ChatAvatar* avatar) { UpdateAvatar(avatar); }
-
-void ChatAvatarService::PersistFriend(
-    uint32_t srcAvatarId, uint32_t destAvatarId, const std::u16string& comment) {
-    sqlite3_stmt* stmt;
-    char sql[] = "INSERT INTO friend (avatar_id, friend_avatar_id, comment) VALUES (@avatar_id, "
-                 "@friend_avatar_id, @comment)";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    auto find_iter = onlineIndex_.find(avatar->GetAvatarId());
+    if (find_iter == std::end(onlineIndex_)) {
+        return;
     }
 
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
-    int friendAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@friend_avatar_id");
-    int commentIdx = sqlite3_bind_parameter_index(stmt, "@comment");
+    // Move the last online avatar into the vacated slot to keep the list dense.
+    auto index = find_iter->second;
+    auto lastAvatar = onlineAvatars_.back();
+    onlineAvatars_[index] = lastAvatar;
+    onlineAvatars_.pop_back();
 
-    std::string commentStr = FromWideString(comment);
+    onlineIndex_[lastAvatar->GetAvatarId()] = index;
+    onlineIndex_.erase(avatar->GetAvatarId());
+}
 
-    sqlite3_bind_int(stmt, avatarIdIdx, srcAvatarId);
-    sqlite3_bind_int(stmt, friendAvatarIdIdx, destAvatarId);
-    sqlite3_bind_text(stmt, commentIdx, commentStr.c_str(), -1, 0);
+void ChatAvatarService::PersistAvatar(const ChatAvatar* avatar) {
+    CHECK_NOTNULL(avatar);
+    avatarStore_->UpdateAvatar(ToRecord(avatar));
+}
 
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+void ChatAvatarService::PersistFriend(
+    uint32_t srcAvatarId, uint32_t destAvatarId, const std::u16string& comment) {
+    contactStore_->AddFriend(srcAvatarId, destAvatarId, comment);
 }
 
 void ChatAvatarService::PersistIgnore(uint32_t srcAvatarId, uint32_t destAvatarId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "INSERT INTO ignore (avatar_id, ignore_avatar_id, comment) VALUES (@avatar_id, "
-                 "@ignore_avatar_id)";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
-    int ignoreAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@ignore_avatar_id");
-
-    sqlite3_bind_int(stmt, avatarIdIdx, srcAvatarId);
-    sqlite3_bind_int(stmt, ignoreAvatarIdIdx, destAvatarId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    contactStore_->AddIgnore(srcAvatarId, destAvatarId);
 }
 
 void ChatAvatarService::RemoveFriend(uint32_t srcAvatarId, uint32_t destAvatarId) {
-    sqlite3_stmt* stmt;
-
-    char sql[] = "DELETE FROM friend WHERE avatar_id = @avatar_id AND friend_avatar_id = "
-                 "@friend_avatar_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
-    int friendAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@friend_avatar_id");
-
-    sqlite3_bind_int(stmt, avatarIdIdx, srcAvatarId);
-    sqlite3_bind_int(stmt, friendAvatarIdIdx, destAvatarId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    contactStore_->RemoveFriend(srcAvatarId, destAvatarId);
 }
 
 void ChatAvatarService::RemoveIgnore(uint32_t srcAvatarId, uint32_t destAvatarId) {
-    sqlite3_stmt* stmt;
-
-    char sql[] = "DELETE FROM ignore WHERE avatar_id = @avatar_id AND ignore_avatar_id = "
-                 "@ignore_avatar_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
-    int ignoreAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@ignore_avatar_id");
-
-    sqlite3_bind_int(stmt, avatarIdIdx, srcAvatarId);
-    sqlite3_bind_int(stmt, ignoreAvatarIdIdx, destAvatarId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    contactStore_->RemoveIgnore(srcAvatarId, destAvatarId);
 }
 
 void ChatAvatarService::UpdateFriendComment(
     uint32_t srcAvatarId, uint32_t destAvatarId, const std::u16string& comment) {
-    sqlite3_stmt* stmt;
-    char sql[] = "UDPATE friend SET comment = @comment WHERE avatar_id = @avatar_id AND "
-                 "friend_avatar_id = @friend_avatar_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int commentIdx = sqlite3_bind_parameter_index(stmt, "@comment");
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
-    int friendAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@friend_avatar_id");
-
-    std::string commentStr = FromWideString(comment);
-
-    sqlite3_bind_text(stmt, commentIdx, commentStr.c_str(), -1, 0);
-    sqlite3_bind_int(stmt, avatarIdIdx, srcAvatarId);
-    sqlite3_bind_int(stmt, friendAvatarIdIdx, destAvatarId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    contactStore_->UpdateFriendComment(srcAvatarId, destAvatarId, comment);
 }
 
 ChatAvatar* ChatAvatarService::GetCachedAvatar(
     const std::u16string& name, const std::u16string& address) {
-    ChatAvatar* avatar = nullptr;
-
-    // First look for the avatar in the cache
-    auto find_iter = std::find_if(
-        std::begin(avatarCache_), std::end(avatarCache_), [name, address](const auto& avatar) {
-            return avatar->name_.compare(name) == 0 && avatar->address_.compare(address) == 0;
-        });
+    auto address_iter = avatarsByAddress_.find(addressTable_->Find(address));
+    if (address_iter == std::end(avatarsByAddress_)) {
+        return nullptr;
+    }
 
-    if (find_iter != std::end(avatarCache_)) {
-        avatar = find_iter->get();
+    auto name_iter = address_iter->second.find(name);
+    if (name_iter == std::end(address_iter->second)) {
+        return nullptr;
     }
 
-    return avatar;
+    return name_iter->second;
 }
 
 ChatAvatar* ChatAvatarService::GetCachedAvatar(uint32_t avatarId) {
-    ChatAvatar* avatar = nullptr;
-
-    // First look for the avatar in the cache
-    auto find_iter = std::find_if(std::begin(avatarCache_), std::end(avatarCache_),
-        [avatarId](const auto& avatar) { return avatar->avatarId_ == avatarId; });
-
-    if (find_iter != std::end(avatarCache_)) {
-        avatar = find_iter->get();
+    auto find_iter = avatarCache_.find(avatarId);
+    if (find_iter == std::end(avatarCache_)) {
+        return nullptr;
     }
 
-    return avatar;
+    return find_iter->second.get();
 }
 
-void ChatAvatarService::RemoveCachedAvatar(uint32_t avatarId) {
-    auto remove_iter = std::remove_if(std::begin(avatarCache_), std::end(avatarCache_),
-                                  [avatarId](const auto& avatar) { return avatar->avatarId_ == avatarId; });
-
-    if (remove_iter != std::end(avatarCache_)) {
-        avatarCache_.erase(remove_iter);
-    }
-}
+ChatAvatar* ChatAvatarService::CacheAvatar(std::unique_ptr<ChatAvatar> avatar) {
+    auto avatarPtr = avatar.get();
 
-void ChatAvatarService::RemoveAsFriendOrIgnoreFromAll(const ChatAvatar* avatar) {
-    for (auto& cachedAvatar : avatarCache_) {
-        if (cachedAvatar->IsFriend(avatar)) {
-            cachedAvatar->RemoveFriend(avatar);
-        }
+    avatarsByAddress_[avatarPtr->addressAtom_][avatarPtr->name_] = avatarPtr;
+    recentAvatars_.push_front(avatarPtr->avatarId_);
+    recentIndex_[avatarPtr->avatarId_] = std::begin(recentAvatars_);
+    avatarCache_[avatarPtr->avatarId_] = std::move(avatar);
 
-        if (cachedAvatar->IsIgnored(avatar)) {
-            cachedAvatar->RemoveIgnore(avatar);
-        }
-    }
+    return avatarPtr;
 }
 
-std::unique_ptr<ChatAvatar> ChatAvatarService::LoadStoredAvatar(
-    const std::u16string& name, const std::u16string& address) {
-    std::unique_ptr<ChatAvatar> avatar{nullptr};
-
-    sqlite3_stmt* stmt;
-
-    char sql[] = "SELECT id, user_id, name, address, attributes FROM avatar WHERE name = @name AND "
-                 "address = @address";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+void ChatAvatarService::RemoveCachedAvatar(uint32_t avatarId) {
+    auto find_iter = avatarCache_.find(avatarId);
+    if (find_iter == std::end(avatarCache_)) {
+        return;
     }
 
-    std::string nameStr = FromWideString(name);
-    std::string addressStr = FromWideString(address);
-
-    int nameIdx = sqlite3_bind_parameter_index(stmt, "@name");
-    int addressIdx = sqlite3_bind_parameter_index(stmt, "@address");
-
-    sqlite3_bind_text(stmt, nameIdx, nameStr.c_str(), -1, 0);
-    sqlite3_bind_text(stmt, addressIdx, addressStr.c_str(), -1, 0);
+    auto& avatar = find_iter->second;
+    UnindexContacts(avatar.get());
 
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        avatar = std::make_unique<ChatAvatar>(this);
-        avatar->avatarId_ = sqlite3_column_int(stmt, 0);
-        avatar->userId_ = sqlite3_column_int(stmt, 1);
-
-        auto tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-        avatar->name_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
-        avatar->address_ = std::u16string(std::begin(tmp), std::end(tmp));
+    auto address_iter = avatarsByAddress_.find(avatar->addressAtom_);
+    if (address_iter != std::end(avatarsByAddress_)) {
+        address_iter->second.erase(avatar->name_);
 
-        avatar->attributes_ = sqlite3_column_int(stmt, 4);
+        if (address_iter->second.empty()) {
+            avatarsByAddress_.erase(address_iter);
+        }
     }
 
-    sqlite3_finalize(stmt);
+    auto recent_iter = recentIndex_.find(avatarId);
+    if (recent_iter != std::end(recentIndex_)) {
+        recentAvatars_.erase(recent_iter->second);
+        recentIndex_.erase(recent_iter);
+    }
 
-    return avatar;
+    avatarCache_.erase(find_iter);
 }
 
-std::unique_ptr<ChatAvatar> ChatAvatarService::LoadStoredAvatar(uint32_t avatarId) {
-    std::unique_ptr<ChatAvatar> avatar{nullptr};
-
-    sqlite3_stmt* stmt;
+void ChatAvatarService::TouchCachedAvatar(uint32_t avatarId) {
+    auto find_iter = recentIndex_.find(avatarId);
+    if (find_iter != std::end(recentIndex_)) {
+        recentAvatars_.splice(std::begin(recentAvatars_), recentAvatars_, find_iter->second);
+    }
+}
 
-    char sql[] = "SELECT id, user_id, name, address, attributes FROM avatar WHERE id = @avatar_id";
+bool ChatAvatarService::IsEvictable(uint32_t avatarId) const {
+    if (onlineIndex_.find(avatarId) != std::end(onlineIndex_)) {
+        return false;
+    }
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    if (pins_.find(avatarId) != std::end(pins_)) {
+        return false;
     }
 
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
+    auto friend_iter = friendedBy_.find(avatarId);
+    if (friend_iter != std::end(friendedBy_)) {
+        for (auto srcAvatarId : friend_iter->second) {
+            if (onlineIndex_.find(srcAvatarId) != std::end(onlineIndex_)) {
+                return false;
+            }
+        }
+    }
 
-    sqlite3_bind_int(stmt, avatarIdIdx, avatarId);
+    return true;
+}
 
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        avatar = std::make_unique<ChatAvatar>(this);
-        avatar->avatarId_ = sqlite3_column_int(stmt, 0);
-        avatar->userId_ = sqlite3_column_int(stmt, 1);
+void ChatAvatarService::TrimCache() {
+    if (maxCachedAvatars_ == 0 || avatarCache_.size() <= maxCachedAvatars_) {
+        return;
+    }
 
-        auto tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-        avatar->name_ = std::u16string{std::begin(tmp), std::end(tmp)};
+    // Walk from the least recently used end, skipping avatars that are online
+    // or still referenced, and bound the work done in a single tick.
+    size_t scanned = 0;
+    auto iter = std::end(recentAvatars_);
+    while (avatarCache_.size() > maxCachedAvatars_ && iter != std::begin(recentAvatars_)
+        && scanned++ < MAX_EVICTION_SCAN) {
+        --iter;
 
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
-        avatar->address_ = std::u16string(std::begin(tmp), std::end(tmp));
+        auto avatarId = *iter;
+        if (!IsEvictable(avatarId)) {
+            continue;
+        }
 
-        avatar->attributes_ = sqlite3_column_int(stmt, 4);
+        iter = std::next(iter);
+        RemoveCachedAvatar(avatarId);
+        ++cacheEvictions_;
     }
-
-    sqlite3_finalize(stmt);
-
-    return avatar;
 }
 
-void ChatAvatarService::InsertAvatar(ChatAvatar* avatar) {
-    CHECK_NOTNULL(avatar);
-    sqlite3_stmt* stmt;
-
-    char sql[] = "INSERT INTO avatar (user_id, name, address, attributes) VALUES (@user_id, @name, "
-                 "@address, @attributes)";
+void ChatAvatarService::PinAvatar(uint32_t avatarId) {
+    ++pins_[avatarId];
+}
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+void ChatAvatarService::UnpinAvatar(uint32_t avatarId) {
+    auto find_iter = pins_.find(avatarId);
+    if (find_iter != std::end(pins_) && --find_iter->second == 0) {
+        pins_.erase(find_iter);
     }
+}
 
-    std::string nameStr = FromWideString(avatar->name_);
-    std::string addressStr = FromWideString(avatar->address_);
-
-    int userIdIdx = sqlite3_bind_parameter_index(stmt, "@user_id");
-    int nameIdx = sqlite3_bind_parameter_index(stmt, "@name");
-    int addressIdx = sqlite3_bind_parameter_index(stmt, "@address");
-    int attributesIdx = sqlite3_bind_parameter_index(stmt, "@attributes");
-
-    sqlite3_bind_int(stmt, userIdIdx, avatar->userId_);
-    sqlite3_bind_text(stmt, nameIdx, nameStr.c_str(), -1, 0);
-    sqlite3_bind_text(stmt, addressIdx, addressStr.c_str(), -1, 0);
-    sqlite3_bind_int(stmt, attributesIdx, avatar->attributes_);
+void ChatAvatarService::RemoveAsFriendOrIgnoreFromAll(const ChatAvatar* avatar) {
+    auto avatarId = avatar->GetAvatarId();
+
+    // Removing a contact updates the reverse index, so work from a copy.
+    auto friend_iter = friendedBy_.find(avatarId);
+    if (friend_iter != std::end(friendedBy_)) {
+        auto srcAvatarIds = friend_iter->second;
+        for (auto srcAvatarId : srcAvatarIds) {
+            auto srcAvatar = GetCachedAvatar(srcAvatarId);
+            if (srcAvatar) {
+                srcAvatar->RemoveFriend(avatar);
+            }
+        }
 
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+        friendedBy_.erase(avatarId);
     }
 
-    avatar->avatarId_ = static_cast<uint32_t>(sqlite3_last_insert_rowid(db_));
+    auto ignore_iter = ignoredBy_.find(avatarId);
+    if (ignore_iter != std::end(ignoredBy_)) {
+        auto srcAvatarIds = ignore_iter->second;
+        for (auto srcAvatarId : srcAvatarIds) {
+            auto srcAvatar = GetCachedAvatar(srcAvatarId);
+            if (srcAvatar) {
+                srcAvatar->RemoveIgnore(avatar);
+            }
+        }
 
-    sqlite3_finalize(stmt);
+        ignoredBy_.erase(avatarId);
+    }
 }
 
-void ChatAvatarService::UpdateAvatar(const ChatAvatar* avatar) {
-    CHECK_NOTNULL(avatar);
-    sqlite3_stmt* stmt;
+void ChatAvatarService::UnindexContacts(const ChatAvatar* avatar) {
+    auto avatarId = avatar->GetAvatarId();
 
-    char sql[] = "UPDATE avatar SET user_id = @user_id, name = @name, address = @address, "
-                 "attributes = @attributes "
-                 "WHERE id = @avatar_id";
+    for (auto& contact : avatar->GetFriendList()) {
+        UnindexFriend(avatarId, contact.frndId);
+    }
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    for (auto& contact : avatar->GetIgnoreList()) {
+        UnindexIgnore(avatarId, contact.ignoredId);
     }
+}
 
-    std::string nameStr = FromWideString(avatar->name_);
-    std::string addressStr = FromWideString(avatar->address_);
+void ChatAvatarService::IndexFriend(uint32_t srcAvatarId, uint32_t destAvatarId) {
+    friendedBy_[destAvatarId].insert(srcAvatarId);
+}
 
-    int userIdIdx = sqlite3_bind_parameter_index(stmt, "@user_id");
-    int nameIdx = sqlite3_bind_parameter_index(stmt, "@name");
-    int addressIdx = sqlite3_bind_parameter_index(stmt, "@address");
-    int attributesIdx = sqlite3_bind_parameter_index(stmt, "@attributes");
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
+void ChatAvatarService::IndexIgnore(uint32_t srcAvatarId, uint32_t destAvatarId) {
+    ignoredBy_[destAvatarId].insert(srcAvatarId);
+}
 
-    sqlite3_bind_int(stmt, userIdIdx, avatar->userId_);
-    sqlite3_bind_text(stmt, nameIdx, nameStr.c_str(), -1, 0);
-    sqlite3_bind_text(stmt, addressIdx, addressStr.c_str(), -1, 0);
-    sqlite3_bind_int(stmt, attributesIdx, avatar->attributes_);
-    sqlite3_bind_int(stmt, avatarIdIdx, avatar->avatarId_);
+void ChatAvatarService::UnindexFriend(uint32_t srcAvatarId, uint32_t destAvatarId) {
+    auto find_iter = friendedBy_.find(destAvatarId);
+    if (find_iter != std::end(friendedBy_)) {
+        find_iter->second.erase(srcAvatarId);
 
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+        if (find_iter->second.empty()) {
+            friendedBy_.erase(find_iter);
+        }
     }
-
-    sqlite3_finalize(stmt);
 }
 
-void ChatAvatarService::DeleteAvatar(ChatAvatar* avatar) {
-    CHECK_NOTNULL(avatar);
-    sqlite3_stmt* stmt;
-
-    char sql[] = "DELETE FROM avatar WHERE id = @avatar_id";
+void ChatAvatarService::UnindexIgnore(uint32_t srcAvatarId, uint32_t destAvatarId) {
+    auto find_iter = ignoredBy_.find(destAvatarId);
+    if (find_iter != std::end(ignoredBy_)) {
+        find_iter->second.erase(srcAvatarId);
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+        if (find_iter->second.empty()) {
+            ignoredBy_.erase(find_iter);
+        }
     }
+}
 
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
+std::vector<ChatAvatar*> ChatAvatarService::GetOnlineAvatarsListingFriend(const ChatAvatar* avatar) {
+    std::vector<ChatAvatar*> avatars;
 
-    sqlite3_bind_int(stmt, avatarIdIdx, avatar->avatarId_);
+    auto find_iter = friendedBy_.find(avatar->GetAvatarId());
+    if (find_iter == std::end(friendedBy_)) {
+        return avatars;
+    }
 
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    for (auto srcAvatarId : find_iter->second) {
+        auto srcAvatar = GetCachedAvatar(srcAvatarId);
+        if (srcAvatar && srcAvatar->IsOnline()) {
+            avatars.push_back(srcAvatar);
+        }
     }
 
-    sqlite3_finalize(stmt);
+    return avatars;
 }
 
-void ChatAvatarService::LoadFriendList(ChatAvatar* avatar) {
-    sqlite3_stmt* stmt;
-
-    char sql[] = "SELECT friend_avatar_id, comment FROM friend WHERE avatar_id = @avatar_id";
+std::unique_ptr<ChatAvatar> ChatAvatarService::LoadStoredAvatar(const boost::optional<AvatarRecord>& record) {
+    std::unique_ptr<ChatAvatar> avatar{nullptr};
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+    if (record) {
+        avatar = std::make_unique<ChatAvatar>(this);
+        avatar->avatarId_ = record->avatarId;
+        avatar->userId_ = record->userId;
+        avatar->name_ = record->name;
+        avatar->addressAtom_ = addressTable_->Intern(record->address);
+        avatar->attributes_ = record->attributes;
     }
 
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
+    return avatar;
+}
+
+AvatarRecord ChatAvatarService::ToRecord(const ChatAvatar* avatar) const {
+    AvatarRecord record;
 
-    sqlite3_bind_int(stmt, avatarIdIdx, avatar->avatarId_);
+    record.avatarId = avatar->avatarId_;
+    record.userId = avatar->userId_;
+    record.name = avatar->name_;
+    record.address = avatar->GetAddress();
+    record.attributes = avatar->attributes_;
 
-    uint32_t tmpFriendId;
-    std::string tmpComment;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        tmpFriendId = sqlite3_column_int(stmt, 0);
-        tmpComment = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    return record;
+}
 
-        auto friendAvatar = GetAvatar(tmpFriendId);
+void ChatAvatarService::LoadFriendList(ChatAvatar* avatar) {
+    for (auto& record : contactStore_->LoadFriends(avatar->avatarId_)) {
+        auto friendId = record.friendAvatarId;
 
-        avatar->friendList_.emplace_back(friendAvatar, ToWideString(tmpComment));
+        auto& contacts = avatar->GetContacts();
+        contacts.friendList.emplace_back(friendId, record.comment);
+        contacts.friendIds.insert(friendId);
+        IndexFriend(avatar->avatarId_, friendId);
     }
 }
 
 void ChatAvatarService::LoadIgnoreList(ChatAvatar* avatar) {
-    sqlite3_stmt* stmt;
-
-    char sql[] = "SELECT ignore_avatar_id FROM ignore WHERE avatar_id = @avatar_id";
+    for (auto& record : contactStore_->LoadIgnores(avatar->avatarId_)) {
+        auto ignoreId = record.ignoreAvatarId;
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+        auto& contacts = avatar->GetContacts();
+        contacts.ignoreList.emplace_back(ignoreId);
+        contacts.ignoreIds.insert(ignoreId);
+        IndexIgnore(avatar->avatarId_, ignoreId);
     }
+}
 
-    int avatarIdIdx = sqlite3_bind_parameter_index(stmt, "@avatar_id");
-
-    sqlite3_bind_int(stmt, avatarIdIdx, avatar->avatarId_);
-
-    uint32_t tmpIgnoreId;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        tmpIgnoreId = sqlite3_column_int(stmt, 0);
-
-        auto ignoreAvatar = GetAvatar(tmpIgnoreId);
-
-        avatar->ignoreList_.emplace_back(ignoreAvatar);
+ChatAvatar* ChatAvatarService::GetOnlineAvatar(uint32_t avatarId) {
+    auto find_iter = onlineIndex_.find(avatarId);
+    if (find_iter == std::end(onlineIndex_)) {
+        return nullptr;
     }
+
+    return onlineAvatars_[find_iter->second];
 }
 
 bool ChatAvatarService::IsOnline(const ChatAvatar * avatar) const {
-    for (auto onlineAvatar : onlineAvatars_) {
-        if (onlineAvatar->GetAvatarId() == avatar->GetAvatarId()) {
-            return true;
-        }
-    }
-
-    return false;
+    return onlineIndex_.find(avatar->GetAvatarId()) != std::end(onlineIndex_);
 }
@@ -1,22 +1,38 @@
 
 #pragma once
 
+#include "AddressTable.hpp"
 #include "ChatAvatar.hpp"
 #include "ChatEnums.hpp"
+#include "ChatStorage.hpp"
 
 #include <boost/optional.hpp>
 
+#include <functional>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
-
-struct sqlite3;
+#include <unordered_set>
 
 class ChatAvatarService {
+    friend class ChatAvatar;
+
 public:
-    explicit ChatAvatarService(sqlite3* db);
+    ChatAvatarService(AddressTable* addressTable, AvatarStore* avatarStore, ContactStore* contactStore);
     ~ChatAvatarService();
     
+    /** Loads every stored avatar along with all friend and ignore links in a
+     * few sequential table scans, instead of lazily one avatar at a time.
+     * Contacts naming an avatar that is no longer stored are kept, the same
+     * as when the lists are loaded lazily.
+     */
+    void WarmLoadAvatars();
+
+    /** Approximate number of bytes held by the avatar cache and its indexes.
+     */
+    size_t EstimateCacheMemory() const;
+
     ChatAvatar* GetAvatar(const std::u16string& name, const std::u16string& address);
     ChatAvatar* GetAvatar(uint32_t avatarId);
 
@@ -39,27 +55,98 @@ public:
     void UpdateFriendComment(uint32_t srcAvatarId, uint32_t destAvatarId, const std::u16string& comment);
 
     const std::vector<ChatAvatar*>& GetOnlineAvatars() const { return onlineAvatars_; }
+
+    /** Returns the avatar if it is logged in, without loading it from storage.
+    */
+    ChatAvatar* GetOnlineAvatar(uint32_t avatarId);
+
+    /** Returns the online avatars that have the given avatar on their friend list.
+    */
+    std::vector<ChatAvatar*> GetOnlineAvatarsListingFriend(const ChatAvatar* avatar);
+
+    /** Caps the number of resident avatars, 0 leaves the cache unbounded.
+    */
+    void SetMaxCachedAvatars(size_t maxCachedAvatars) { maxCachedAvatars_ = maxCachedAvatars; }
+
+    /** Evicts least recently used avatars while the cache is over its cap.
+     *
+     * Online avatars, avatars on an online avatar's friend list and avatars
+     * pinned by a room are never evicted. Evicted avatars are reloaded from
+     * storage on their next lookup.
+     */
+    void TrimCache();
+
+    /** Keeps an avatar resident while something holds on to its pointer.
+    */
+    void PinAvatar(uint32_t avatarId);
+    void UnpinAvatar(uint32_t avatarId);
+
+    AddressTable* GetAddressTable() const { return addressTable_; }
+
+    size_t GetCachedAvatarCount() const { return avatarCache_.size(); }
+    uint64_t GetCacheHits() const { return cacheHits_; }
+    uint64_t GetCacheMisses() const { return cacheMisses_; }
+    uint64_t GetCacheEvictions() const { return cacheEvictions_; }
     
 private:
     ChatAvatar* GetCachedAvatar(const std::u16string& name, const std::u16string& address);
     ChatAvatar* GetCachedAvatar(uint32_t avatarId);
 
+    ChatAvatar* CacheAvatar(std::unique_ptr<ChatAvatar> avatar);
     void RemoveCachedAvatar(uint32_t avatarId);
+    void TouchCachedAvatar(uint32_t avatarId);
+    bool IsEvictable(uint32_t avatarId) const;
     void RemoveAsFriendOrIgnoreFromAll(const ChatAvatar* avatar);
+    void UnindexContacts(const ChatAvatar* avatar);
+
+    /** Keep the reverse contact indexes in step with the cached contact lists,
+     * called wherever a list gains or loses an entry.
+     */
+    void IndexFriend(uint32_t srcAvatarId, uint32_t destAvatarId);
+    void IndexIgnore(uint32_t srcAvatarId, uint32_t destAvatarId);
+    void UnindexFriend(uint32_t srcAvatarId, uint32_t destAvatarId);
+    void UnindexIgnore(uint32_t srcAvatarId, uint32_t destAvatarId);
     
-    std::unique_ptr<ChatAvatar> LoadStoredAvatar(const std::u16string& name, const std::u16string& address);
-    std::unique_ptr<ChatAvatar> LoadStoredAvatar(uint32_t avatarId);
-
-    void InsertAvatar(ChatAvatar* avatar);
-    void UpdateAvatar(const ChatAvatar* avatar);
-    void DeleteAvatar(ChatAvatar* avatar);
+    std::unique_ptr<ChatAvatar> LoadStoredAvatar(const boost::optional<AvatarRecord>& record);
+    AvatarRecord ToRecord(const ChatAvatar* avatar) const;
 
     void LoadFriendList(ChatAvatar* avatar);
     void LoadIgnoreList(ChatAvatar* avatar);
 
     bool IsOnline(const ChatAvatar* avatar) const;
 
-    std::vector<std::unique_ptr<ChatAvatar>> avatarCache_;
+    // Owns every loaded avatar, keyed by avatar id. Entries are heap allocated
+    // so the ChatAvatar* handles given out remain valid while cached.
+    std::unordered_map<uint32_t, std::unique_ptr<ChatAvatar>> avatarCache_;
+    // Secondary index of the cached avatars by address and then by name. The
+    // name keys refer to the cached avatar's own name rather than a copy.
+    using NameRef = std::reference_wrapper<const std::u16string>;
+    struct NameRefHash {
+        size_t operator()(NameRef name) const { return std::hash<std::u16string>{}(name.get()); }
+    };
+    struct NameRefEqual {
+        bool operator()(NameRef lhs, NameRef rhs) const { return lhs.get() == rhs.get(); }
+    };
+    using NameIndex = std::unordered_map<NameRef, ChatAvatar*, NameRefHash, NameRefEqual>;
+    std::unordered_map<AddressAtom, NameIndex> avatarsByAddress_;
+    // Dense list of online avatars for iteration, with each avatar's position
+    // indexed by id so logins and logouts are constant time.
     std::vector<ChatAvatar*> onlineAvatars_;
-    sqlite3* db_;
+    std::unordered_map<uint32_t, size_t> onlineIndex_;
+    // Reverse contact indexes mapping an avatar id to the ids of the cached
+    // avatars that have it on their friend or ignore list.
+    std::unordered_map<uint32_t, std::unordered_set<uint32_t>> friendedBy_;
+    std::unordered_map<uint32_t, std::unordered_set<uint32_t>> ignoredBy_;
+    // Cached avatar ids from most to least recently used.
+    std::list<uint32_t> recentAvatars_;
+    std::unordered_map<uint32_t, std::list<uint32_t>::iterator> recentIndex_;
+    // avatar id -> number of outstanding pins
+    std::unordered_map<uint32_t, uint32_t> pins_;
+    size_t maxCachedAvatars_ = 0;
+    uint64_t cacheHits_ = 0;
+    uint64_t cacheMisses_ = 0;
+    uint64_t cacheEvictions_ = 0;
+    AddressTable* addressTable_;
+    AvatarStore* avatarStore_;
+    ContactStore* contactStore_;
 };
@@ -1,5 +1,162 @@
 #include "ChatEnums.hpp"
 
+const char* ToString(ChatRequestType type) {
+    switch (type) {
+    case ChatRequestType::LOGINAVATAR:
+        return "LOGINAVATAR";
+    case ChatRequestType::LOGOUTAVATAR:
+        return "LOGOUTAVATAR";
+    case ChatRequestType::DESTROYAVATAR:
+        return "DESTROYAVATAR";
+    case ChatRequestType::GETAVATAR:
+        return "GETAVATAR";
+    case ChatRequestType::CREATEROOM:
+        return "CREATEROOM";
+    case ChatRequestType::DESTROYROOM:
+        return "DESTROYROOM";
+    case ChatRequestType::SENDINSTANTMESSAGE:
+        return "SENDINSTANTMESSAGE";
+    case ChatRequestType::SENDROOMMESSAGE:
+        return "SENDROOMMESSAGE";
+    case ChatRequestType::SENDBROADCASTMESSAGE:
+        return "SENDBROADCASTMESSAGE";
+    case ChatRequestType::ADDFRIEND:
+        return "ADDFRIEND";
+    case ChatRequestType::REMOVEFRIEND:
+        return "REMOVEFRIEND";
+    case ChatRequestType::FRIENDSTATUS:
+        return "FRIENDSTATUS";
+    case ChatRequestType::ADDIGNORE:
+        return "ADDIGNORE";
+    case ChatRequestType::REMOVEIGNORE:
+        return "REMOVEIGNORE";
+    case ChatRequestType::ENTERROOM:
+        return "ENTERROOM";
+    case ChatRequestType::LEAVEROOM:
+        return "LEAVEROOM";
+    case ChatRequestType::ADDMODERATOR:
+        return "ADDMODERATOR";
+    case ChatRequestType::REMOVEMODERATOR:
+        return "REMOVEMODERATOR";
+    case ChatRequestType::ADDBAN:
+        return "ADDBAN";
+    case ChatRequestType::REMOVEBAN:
+        return "REMOVEBAN";
+    case ChatRequestType::ADDINVITE:
+        return "ADDINVITE";
+    case ChatRequestType::REMOVEINVITE:
+        return "REMOVEINVITE";
+    case ChatRequestType::KICKAVATAR:
+        return "KICKAVATAR";
+    case ChatRequestType::SETROOMPARAMS:
+        return "SETROOMPARAMS";
+    case ChatRequestType::GETROOM:
+        return "GETROOM";
+    case ChatRequestType::GETROOMSUMMARIES:
+        return "GETROOMSUMMARIES";
+    case ChatRequestType::SENDPERSISTENTMESSAGE:
+        return "SENDPERSISTENTMESSAGE";
+    case ChatRequestType::GETPERSISTENTHEADERS:
+        return "GETPERSISTENTHEADERS";
+    case ChatRequestType::GETPERSISTENTMESSAGE:
+        return "GETPERSISTENTMESSAGE";
+    case ChatRequestType::UPDATEPERSISTENTMESSAGE:
+        return "UPDATEPERSISTENTMESSAGE";
+    case ChatRequestType::UNREGISTERROOM:
+        return "UNREGISTERROOM";
+    case ChatRequestType::IGNORESTATUS:
+        return "IGNORESTATUS";
+    case ChatRequestType::FAILOVER_RELOGINAVATAR:
+        return "FAILOVER_RELOGINAVATAR";
+    case ChatRequestType::FAILOVER_RECREATEROOM:
+        return "FAILOVER_RECREATEROOM";
+    case ChatRequestType::CONFIRMFRIEND:
+        return "CONFIRMFRIEND";
+    case ChatRequestType::GETAVATARKEYWORDS:
+        return "GETAVATARKEYWORDS";
+    case ChatRequestType::SETAVATARKEYWORDS:
+        return "SETAVATARKEYWORDS";
+    case ChatRequestType::SEARCHAVATARKEYWORDS:
+        return "SEARCHAVATARKEYWORDS";
+    case ChatRequestType::GETFANCLUBHANDLE:
+        return "GETFANCLUBHANDLE";
+    case ChatRequestType::UPDATEPERSISTENTMESSAGES:
+        return "UPDATEPERSISTENTMESSAGES";
+    case ChatRequestType::FINDAVATARBYUID:
+        return "FINDAVATARBYUID";
+    case ChatRequestType::CHANGEROOMOWNER:
+        return "CHANGEROOMOWNER";
+    case ChatRequestType::SETAPIVERSION:
+        return "SETAPIVERSION";
+    case ChatRequestType::ADDTEMPORARYMODERATOR:
+        return "ADDTEMPORARYMODERATOR";
+    case ChatRequestType::REMOVETEMPORARYMODERATOR:
+        return "REMOVETEMPORARYMODERATOR";
+    case ChatRequestType::GRANTVOICE:
+        return "GRANTVOICE";
+    case ChatRequestType::REVOKEVOICE:
+        return "REVOKEVOICE";
+    case ChatRequestType::SETAVATARATTRIBUTES:
+        return "SETAVATARATTRIBUTES";
+    case ChatRequestType::ADDSNOOPAVATAR:
+        return "ADDSNOOPAVATAR";
+    case ChatRequestType::REMOVESNOOPAVATAR:
+        return "REMOVESNOOPAVATAR";
+    case ChatRequestType::ADDSNOOPROOM:
+        return "ADDSNOOPROOM";
+    case ChatRequestType::REMOVESNOOPROOM:
+        return "REMOVESNOOPROOM";
+    case ChatRequestType::GETSNOOPLIST:
+        return "GETSNOOPLIST";
+    case ChatRequestType::PARTIALPERSISTENTHEADERS:
+        return "PARTIALPERSISTENTHEADERS";
+    case ChatRequestType::COUNTPERSISTENTMESSAGES:
+        return "COUNTPERSISTENTMESSAGES";
+    case ChatRequestType::PURGEPERSISTENTMESSAGES:
+        return "PURGEPERSISTENTMESSAGES";
+    case ChatRequestType::SETFRIENDCOMMENT:
+        return "SETFRIENDCOMMENT";
+    case ChatRequestType::TRANSFERAVATAR:
+        return "TRANSFERAVATAR";
+    case ChatRequestType::CHANGEPERSISTENTFOLDER:
+        return "CHANGEPERSISTENTFOLDER";
+    case ChatRequestType::ALLOWROOMENTRY:
+        return "ALLOWROOMENTRY";
+    case ChatRequestType::SETAVATAREMAIL:
+        return "SETAVATAREMAIL";
+    case ChatRequestType::SETAVATARINBOXLIMIT:
+        return "SETAVATARINBOXLIMIT";
+    case ChatRequestType::SENDMULTIPLEPERSISTENTMESSAGES:
+        return "SENDMULTIPLEPERSISTENTMESSAGES";
+    case ChatRequestType::GETMULTIPLEPERSISTENTMESSAGES:
+        return "GETMULTIPLEPERSISTENTMESSAGES";
+    case ChatRequestType::ALTERPERISTENTMESSAGE:
+        return "ALTERPERISTENTMESSAGE";
+    case ChatRequestType::GETANYAVATAR:
+        return "GETANYAVATAR";
+    case ChatRequestType::TEMPORARYAVATAR:
+        return "TEMPORARYAVATAR";
+    case ChatRequestType::AVATARLIST:
+        return "AVATARLIST";
+    case ChatRequestType::SETAVATARSTATUSMESSAGE:
+        return "SETAVATARSTATUSMESSAGE";
+    case ChatRequestType::CONFIRMFRIEND_RECIPROCATE:
+        return "CONFIRMFRIEND_RECIPROCATE";
+    case ChatRequestType::ADDFRIEND_RECIPROCATE:
+        return "ADDFRIEND_RECIPROCATE";
+    case ChatRequestType::REMOVEFRIEND_RECIPROCATE:
+        return "REMOVEFRIEND_RECIPROCATE";
+    case ChatRequestType::FILTERMESSAGE:
+        return "FILTERMESSAGE";
+    case ChatRequestType::FILTERMESSAGE_EX:
+        return "FILTERMESSAGE_EX";
+    case ChatRequestType::REGISTRAR_GETCHATSERVER:
+        return "REGISTRAR_GETCHATSERVER";
+    };
+
+    return "";
+}
+
 const char* ToString(ChatResultCode code) {
     switch (code) {
     case ChatResultCode::SUCCESS:
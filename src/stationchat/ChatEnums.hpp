@@ -249,4 +249,5 @@ struct ChatResultException {
         , message{text} {}
 };
 
+const char* ToString(ChatRequestType type);
 const char* ToString(ChatResultCode code);
\ No newline at end of file
@@ -1,6 +1,7 @@
 
 #include "ChatRoom.hpp"
 #include "ChatAvatar.hpp"
+#include "ChatAvatarService.hpp"
 #include "ChatRoomService.hpp"
 
 #include <algorithm>
@@ -19,11 +20,24 @@ ChatRoom::ChatRoom(ChatRoomService* roomService, uint32_t roomId, const ChatAvat
     , roomTopic_{roomTopic}
     , roomPassword_{roomPassword}
     , roomAddress_{roomAddress + u"+" + roomName}
+    , creatorAddressAtom_{creator->GetAddressAtom()}
     , creatorId_{creator->GetAvatarId()}
     , roomAttributes_{roomAttributes}
     , maxRoomSize_{maxRoomSize} {
-    administrators_.push_back(creator);
-    moderators_.push_back(creator);
+    AddMember(administrators_, creator);
+    AddMember(moderators_, creator);
+}
+
+ChatRoom::~ChatRoom() {
+    for (auto avatar : avatars_) {
+        UnpinAvatar(avatar->GetAvatarId());
+    }
+
+    for (auto members : {&administrators_, &moderators_, &tempModerators_, &banned_, &invited_, &voice_}) {
+        for (auto avatar : *members) {
+            UnpinAvatar(avatar->GetAvatarId());
+        }
+    }
 }
 
 bool ChatRoom::IsPrivate() const {
@@ -64,6 +78,9 @@ void ChatRoom::EnterRoom(ChatAvatar* avatar, const std::u16string& password) {
     }
 
     avatars_.push_back(avatar);
+    PinAvatar(avatar->GetAvatarId());
+    ++connectedAddresses_[avatar->GetAddressAtom()];
+    roomService_->OnEnterRoom(this, avatar->GetAvatarId());
 }
 
 bool ChatRoom::IsInRoom(ChatAvatar* avatar) const { return IsInRoom(avatar->GetAvatarId()); }
@@ -79,15 +96,25 @@ void ChatRoom::LeaveRoom(ChatAvatar* avatar) {
         [avatar](auto roomAvatar) { return roomAvatar->GetAvatarId() == avatar->GetAvatarId(); });
 
     if (avatarsIter != std::end(avatars_)) {
-        avatars_.erase(avatarsIter);
+        avatars_.erase(avatarsIter, std::end(avatars_));
+        UnpinAvatar(avatar->GetAvatarId());
+
+        auto addressIter = connectedAddresses_.find(avatar->GetAddressAtom());
+        if (addressIter != std::end(connectedAddresses_) && --addressIter->second == 0) {
+            connectedAddresses_.erase(addressIter);
+        }
+
+        roomService_->OnLeaveRoom(this, avatar->GetAvatarId());
     }
 }
 
 std::vector<uint32_t> ChatRoom::GetAvatarIds(const ChatAvatar * srcAvatar) const {
     std::vector<uint32_t> avatarIds;
+    avatarIds.reserve(avatars_.size());
 
+    auto srcAvatarId = srcAvatar->GetAvatarId();
     for (auto roomAvatar : avatars_) {
-        if (!roomAvatar->IsIgnored(srcAvatar)) {
+        if (!roomAvatar->IsIgnored(srcAvatarId)) {
             avatarIds.push_back(roomAvatar->GetAvatarId());
         }
     }
@@ -95,36 +122,24 @@ std::vector<uint32_t> ChatRoom::GetAvatarIds(const ChatAvatar * srcAvatar) const
     return avatarIds;
 }
 
-std::vector<std::u16string> ChatRoom::GetConnectedAddresses() const {
-    std::vector<std::u16string> connectedAddresses;
+std::vector<AddressAtom> ChatRoom::GetConnectedAddresses() const {
+    std::vector<AddressAtom> connectedAddresses;
+    connectedAddresses.reserve(connectedAddresses_.size());
 
-    std::u16string address;
-    for (auto avatar : avatars_) {
-        address = avatar->GetAddress();
-        if (connectedAddresses.empty()
-            || std::none_of(std::begin(connectedAddresses), std::end(connectedAddresses),
-                   [&address](const auto& connectedAddress) {
-                       return connectedAddress.compare(address) == 0;
-                   })) {
-            connectedAddresses.push_back(address);
-        }
+    for (auto& address : connectedAddresses_) {
+        connectedAddresses.push_back(address.first);
     }
 
     return connectedAddresses;
 }
 
-std::vector<std::u16string> ChatRoom::GetRemoteAddresses() const {
-    std::vector<std::u16string> connectedAddresses;
+std::vector<AddressAtom> ChatRoom::GetRemoteAddresses() const {
+    std::vector<AddressAtom> connectedAddresses;
+    connectedAddresses.reserve(connectedAddresses_.size());
 
-    std::u16string address;
-    for (auto avatar : avatars_) {
-        address = avatar->GetAddress();
-        if (creatorAddress_.compare(address) != 0 && (connectedAddresses.empty()
-            || std::none_of(std::begin(connectedAddresses), std::end(connectedAddresses),
-                            [&address](const auto& connectedAddress) {
-            return connectedAddress.compare(address) == 0;
-        }))) {
-            connectedAddresses.push_back(address);
+    for (auto& address : connectedAddresses_) {
+        if (address.first != creatorAddressAtom_) {
+            connectedAddresses.push_back(address.first);
         }
     }
 
@@ -191,7 +206,7 @@ void ChatRoom::AddAdministrator(uint32_t srcAvatarId, ChatAvatar* administrator)
     }
 
     if (!IsAdministrator(administrator->GetAvatarId())) {
-        administrators_.push_back(administrator);
+        AddMember(administrators_, administrator);
 
         if (IsPersistent()) {
             roomService_->PersistBanned(administrator->GetAvatarId(), roomId_);
@@ -208,7 +223,7 @@ void ChatRoom::AddModerator(uint32_t srcAvatarId, ChatAvatar* moderator) {
         throw ChatResultException{ChatResultCode::ROOM_DUPLICATEMODERATOR};
     }
 
-    moderators_.push_back(moderator);
+    AddMember(moderators_, moderator);
 
     if (IsPersistent()) {
         roomService_->PersistBanned(moderator->GetAvatarId(), roomId_);
@@ -224,7 +239,7 @@ void ChatRoom::AddBanned(uint32_t srcAvatarId, ChatAvatar* banned) {
         throw ChatResultException{ChatResultCode::ROOM_DUPLICATEBAN};
     }
 
-    banned_.push_back(banned);
+    AddMember(banned_, banned);
 
     if (IsPersistent()) {
         roomService_->PersistBanned(banned->GetAvatarId(), roomId_);
@@ -240,7 +255,7 @@ void ChatRoom::AddInvite(uint32_t srcAvatarId, ChatAvatar* invited) {
         throw ChatResultException{ChatResultCode::ROOM_DUPLICATEINVITE};
     }
 
-    invited_.push_back(invited);
+    AddMember(invited_, invited);
 }
 
 void ChatRoom::RemoveAdministrator(uint32_t srcAvatarId, uint32_t avatarId) {
@@ -251,8 +266,7 @@ void ChatRoom::RemoveAdministrator(uint32_t srcAvatarId, uint32_t avatarId) {
     if (administrators_.empty())
         return;
 
-    administrators_.erase(std::remove_if(std::begin(administrators_), std::end(administrators_),
-        [avatarId](auto administrator) { return administrator->GetAvatarId() == avatarId; }));
+    RemoveMember(administrators_, avatarId);
 
     if (IsPersistent()) {
         roomService_->DeleteAdministrator(avatarId, roomId_);
@@ -268,8 +282,7 @@ void ChatRoom::RemoveModerator(uint32_t srcAvatarId, uint32_t avatarId) {
         throw ChatResultException{ChatResultCode::ROOM_DESTAVATARNOTMODERATOR};
     }
 
-    moderators_.erase(std::remove_if(std::begin(moderators_), std::end(moderators_),
-        [avatarId](auto moderator) { return moderator->GetAvatarId() == avatarId; }));
+    RemoveMember(moderators_, avatarId);
 
     if (IsPersistent()) {
         roomService_->DeleteModerator(avatarId, roomId_);
@@ -285,8 +298,7 @@ void ChatRoom::RemoveBanned(uint32_t srcAvatarId, uint32_t avatarId) {
         throw ChatResultException{ChatResultCode::ROOM_DESTAVATARNOTBANNED};
     }
 
-    banned_.erase(std::remove_if(std::begin(banned_), std::end(banned_),
-        [avatarId](auto banned) { return banned->GetAvatarId() == avatarId; }));
+    RemoveMember(banned_, avatarId);
 
     if (IsPersistent()) {
         roomService_->DeleteBanned(avatarId, roomId_);
@@ -302,6 +314,33 @@ void ChatRoom::RemoveInvite(uint32_t srcAvatarId, uint32_t avatarId) {
         throw ChatResultException{ChatResultCode::ROOM_DESTAVATARNOTINVITED};
     }
 
-    invited_.erase(std::remove_if(std::begin(invited_), std::end(invited_),
-        [avatarId](auto invited) { return invited->GetAvatarId() == avatarId; }));
+    RemoveMember(invited_, avatarId);
+}
+
+void ChatRoom::AddMember(std::vector<const ChatAvatar*>& members, const ChatAvatar* avatar) {
+    members.push_back(avatar);
+    PinAvatar(avatar->GetAvatarId());
+}
+
+void ChatRoom::RemoveMember(std::vector<const ChatAvatar*>& members, uint32_t avatarId) {
+    auto remove_iter = std::remove_if(std::begin(members), std::end(members),
+        [avatarId](auto member) { return member->GetAvatarId() == avatarId; });
+
+    for (auto iter = remove_iter; iter != std::end(members); ++iter) {
+        UnpinAvatar(avatarId);
+    }
+
+    members.erase(remove_iter, std::end(members));
+}
+
+void ChatRoom::PinAvatar(uint32_t avatarId) {
+    if (roomService_) {
+        roomService_->avatarService_->PinAvatar(avatarId);
+    }
+}
+
+void ChatRoom::UnpinAvatar(uint32_t avatarId) {
+    if (roomService_) {
+        roomService_->avatarService_->UnpinAvatar(avatarId);
+    }
 }
@@ -1,9 +1,11 @@
 
 #pragma once
 
+#include "AddressTable.hpp"
 #include "ChatEnums.hpp"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class ChatAvatar;
@@ -19,11 +21,19 @@ enum class RoomAttributes : uint32_t {
 
 class ChatRoom {
 public:
+    /** Gateway address atom -> number of room members connected through it.
+    */
+    using AddressCounts = std::unordered_map<AddressAtom, uint32_t>;
+
     ChatRoom() = default;
     ChatRoom(ChatRoomService* roomService, uint32_t roomId, const ChatAvatar* creator,
              const std::u16string& roomName, const std::u16string& roomTopic, const std::u16string& roomPassword,
              uint32_t roomAttributes, uint32_t maxRoomSize, const std::u16string& roomAddress,
              const std::u16string& srcAddress);
+    ~ChatRoom();
+
+    ChatRoom(const ChatRoom&) = delete;
+    ChatRoom& operator=(const ChatRoom&) = delete;
 
     bool IsPrivate() const;
     bool IsModerated() const;
@@ -65,8 +75,9 @@ public:
     /* Returns the addresses of the different game servers currently with avatars
     * connected to this room.
     */
-    std::vector<std::u16string> GetConnectedAddresses() const;
-    std::vector<std::u16string> GetRemoteAddresses() const;
+    std::vector<AddressAtom> GetConnectedAddresses() const;
+    std::vector<AddressAtom> GetRemoteAddresses() const;
+    const AddressCounts& GetConnectedAddressCounts() const { return connectedAddresses_; }
 
     bool IsCreator(uint32_t avatarId) const;
     bool IsModerator(uint32_t avatarId) const;
@@ -90,7 +101,16 @@ public:
 
 private:
     friend class ChatRoomService;
-    ChatRoomService* roomService_;
+
+    /** Role lists and the member list pin the avatars they point to so the
+     * avatar cache never evicts them from under the room.
+     */
+    void AddMember(std::vector<const ChatAvatar*>& members, const ChatAvatar* avatar);
+    void RemoveMember(std::vector<const ChatAvatar*>& members, uint32_t avatarId);
+    void PinAvatar(uint32_t avatarId);
+    void UnpinAvatar(uint32_t avatarId);
+
+    ChatRoomService* roomService_ = nullptr;
     std::u16string creatorName_;
     std::u16string creatorAddress_;
     std::u16string roomName_;
@@ -99,6 +119,7 @@ private:
     std::u16string roomPrefix_ = u"";
     std::u16string roomAddress_;
 
+    AddressAtom creatorAddressAtom_ = NULL_ADDRESS_ATOM;
     uint32_t creatorId_;
     uint32_t roomAttributes_;
     uint32_t maxRoomSize_;
@@ -109,6 +130,7 @@ private:
     int32_t dbId_ = -1;
 
     std::vector<ChatAvatar*> avatars_;
+    AddressCounts connectedAddresses_;
     std::vector<const ChatAvatar*> administrators_;
     std::vector<const ChatAvatar*> moderators_;
     std::vector<const ChatAvatar*> tempModerators_;
@@ -1,72 +1,52 @@
 #include "ChatRoomService.hpp"
 #include "ChatAvatarService.hpp"
-#include "SQLite3.hpp"
 #include "StreamUtils.hpp"
 #include "StringUtils.hpp"
 
 #include "easylogging++.h"
 
-ChatRoomService::ChatRoomService(ChatAvatarService* avatarService, sqlite3* db)
+namespace {
+const size_t MAX_CACHED_ROOM_SUMMARIES = 256;
+}
+
+ChatRoomService::ChatRoomService(ChatAvatarService* avatarService, RoomStore* roomStore)
     : avatarService_{avatarService}
-    , db_{db} {}
+    , roomStore_{roomStore} {}
 
 ChatRoomService::~ChatRoomService() {}
 
 void ChatRoomService::LoadRoomsFromStorage(const std::u16string& baseAddress) {
     rooms_.clear();
+    roomsByAddress_.clear();
+    joinedRooms_.clear();
+    roomDirectory_.clear();
+    summaryCache_.clear();
+    ++directoryGeneration_;
 
-    sqlite3_stmt* stmt;
-
-    char sql[] = "SELECT id, creator_id, creator_name, creator_address, room_name, room_topic, "
-                 "room_password, room_prefix, room_address, room_attributes, room_max_size, "
-                 "room_message_id, created_at, node_level FROM room WHERE room_address LIKE @baseAddress||'%'";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, 0) != SQLITE_OK) {
-        throw std::runtime_error("Error preparing SQL statement");
-    }
-
-    int baseAddressIdx = sqlite3_bind_parameter_index(stmt, "@baseAddress");
+    LOG(INFO) << "Loading rooms for base address: " << FromWideString(baseAddress);
 
-    auto baseAddressStr = FromWideString(baseAddress);
-    LOG(INFO) << "Loading rooms for base address: " << baseAddressStr;
-    sqlite3_bind_text(stmt, baseAddressIdx, baseAddressStr.c_str(), -1, 0);
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    for (auto& record : roomStore_->LoadRooms(baseAddress)) {
         auto room = std::make_unique<ChatRoom>();
-        std::string tmp;
+        room->roomService_ = this;
         room->roomId_ = nextRoomId_++;
-        room->dbId_ = sqlite3_column_int(stmt, 0);
-        room->creatorId_ = sqlite3_column_int(stmt, 1);
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-        room->creatorName_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
-        room->creatorAddress_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4)));
-        room->roomName_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
-        room->roomTopic_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6)));
-        room->roomPassword_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7)));
-        room->roomPrefix_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        tmp = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8)));
-        room->roomAddress_ = std::u16string{std::begin(tmp), std::end(tmp)};
-
-        room->roomAttributes_ = sqlite3_column_int(stmt, 9);
-        room->maxRoomSize_ = sqlite3_column_int(stmt, 10);
-        room->roomMessageId_ = sqlite3_column_int(stmt, 11);
-        room->createTime_ = sqlite3_column_int(stmt, 12);
-        room->nodeLevel_ = sqlite3_column_int(stmt, 13);
+        room->dbId_ = record.roomId;
+        room->creatorId_ = record.creatorId;
+        room->creatorName_ = std::move(record.creatorName);
+        room->creatorAddress_ = std::move(record.creatorAddress);
+        room->creatorAddressAtom_ = avatarService_->GetAddressTable()->Intern(room->creatorAddress_);
+        room->roomName_ = std::move(record.roomName);
+        room->roomTopic_ = std::move(record.roomTopic);
+        room->roomPassword_ = std::move(record.roomPassword);
+        room->roomPrefix_ = std::move(record.roomPrefix);
+        room->roomAddress_ = std::move(record.roomAddress);
+        room->roomAttributes_ = record.roomAttributes;
+        room->maxRoomSize_ = record.maxRoomSize;
+        room->roomMessageId_ = record.roomMessageId;
+        room->createTime_ = record.createTime;
+        room->nodeLevel_ = record.nodeLevel;
 
         if (!RoomExists(room->GetRoomAddress())) {
-            rooms_.emplace_back(std::move(room));
+            TrackRoom(std::move(room));
         }
     }
 
@@ -86,9 +66,8 @@ ChatRoom* ChatRoomService::CreateRoom(const ChatAvatar* creator,
     LOG(INFO) << "Creating room " << FromWideString(roomName) << "@" << FromWideString(roomAddress) << " with attributes "
               << roomAttributes;
 
-    rooms_.emplace_back(std::make_unique<ChatRoom>(this, nextRoomId_++, creator, roomName,
+    roomPtr = TrackRoom(std::make_unique<ChatRoom>(this, nextRoomId_++, creator, roomName,
         roomTopic, roomPassword, roomAttributes, maxRoomSize, roomAddress, srcAddress));
-    roomPtr = rooms_.back().get();
 
     if (roomPtr->IsPersistent()) {
         PersistNewRoom(*roomPtr);
@@ -102,72 +81,40 @@ void ChatRoomService::DestroyRoom(ChatRoom* room) {
         DeleteRoom(room);
     }
 
-    rooms_.erase(std::remove_if(std::begin(rooms_), std::end(rooms_),
-        [room](const auto& trackedRoom) { return trackedRoom->GetRoomId() == room->GetRoomId(); }));
+    for (auto avatar : room->GetAvatars()) {
+        OnLeaveRoom(room, avatar->GetAvatarId());
+    }
+
+    roomsByAddress_.erase(room->GetRoomAddress());
+    roomDirectory_.erase(room->GetRoomAddress());
+    ++directoryGeneration_;
+
+    rooms_.erase(room->GetRoomId());
 }
 
 ChatResultCode ChatRoomService::PersistNewRoom(ChatRoom& room) {
     ChatResultCode result = ChatResultCode::SUCCESS;
-    sqlite3_stmt* stmt;
-
-    char sql[] = "INSERT INTO room (creator_id, creator_name, creator_address, room_name, "
-                 "room_topic, room_password, room_prefix, room_address, room_attributes, "
-                 "room_max_size, room_message_id, created_at, node_level) VALUES (@creator_id, "
-                 "@creator_name, @creator_address, @room_name, @room_topic, @room_password, "
-                 "@room_prefix, @room_address, @room_attributes, @room_max_size, @room_message_id, "
-                 "@created_at, @node_level)";
-
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, 0) != SQLITE_OK) {
-        result = ChatResultCode::DBFAIL;
-    } else {
-        int creatorIdIdx = sqlite3_bind_parameter_index(stmt, "@creator_id");
-        int creatorNameIdx = sqlite3_bind_parameter_index(stmt, "@creator_name");
-        int creatorAddressIdx = sqlite3_bind_parameter_index(stmt, "@creator_address");
-        int roomNameIdx = sqlite3_bind_parameter_index(stmt, "@room_name");
-        int roomTopicIdx = sqlite3_bind_parameter_index(stmt, "@room_topic");
-        int roomPasswordIdx = sqlite3_bind_parameter_index(stmt, "@room_password");
-        int roomPrefixIdx = sqlite3_bind_parameter_index(stmt, "@room_prefix");
-        int roomAddressIdx = sqlite3_bind_parameter_index(stmt, "@room_address");
-        int roomAttributesIdx = sqlite3_bind_parameter_index(stmt, "@room_attributes");
-        int roomMaxSizeIdx = sqlite3_bind_parameter_index(stmt, "@room_max_size");
-        int roomMessageIdIdx = sqlite3_bind_parameter_index(stmt, "@room_message_id");
-        int createdAtIdx = sqlite3_bind_parameter_index(stmt, "@created_at");
-        int nodeLevelIdx = sqlite3_bind_parameter_index(stmt, "@node_level");
-
-        sqlite3_bind_int(stmt, creatorIdIdx, room.creatorId_);
-
-        auto creatorName = FromWideString(room.creatorName_);
-        sqlite3_bind_text(stmt, creatorNameIdx, creatorName.c_str(), -1, 0);
-
-        auto creatorAddress = FromWideString(room.creatorAddress_);
-        sqlite3_bind_text(stmt, creatorAddressIdx, creatorAddress.c_str(), -1, 0);
-
-        auto roomName = FromWideString(room.roomName_);
-        sqlite3_bind_text(stmt, roomNameIdx, roomName.c_str(), -1, 0);
-
-        auto roomTopic = FromWideString(room.roomTopic_);
-        sqlite3_bind_text(stmt, roomTopicIdx, roomTopic.c_str(), -1, 0);
-
-        auto roomPassword = FromWideString(room.roomPassword_);
-        sqlite3_bind_text(stmt, roomPasswordIdx, roomPassword.c_str(), -1, 0);
-
-        auto roomPrefix = FromWideString(room.roomPrefix_);
-        sqlite3_bind_text(stmt, roomPrefixIdx, roomPrefix.c_str(), -1, 0);
-
-        auto roomAddress = FromWideString(room.roomAddress_);
-        sqlite3_bind_text(stmt, roomAddressIdx, roomAddress.c_str(), -1, 0);
-
-        sqlite3_bind_int(stmt, roomAttributesIdx, room.roomAttributes_);
-        sqlite3_bind_int(stmt, roomMaxSizeIdx, room.maxRoomSize_);
-        sqlite3_bind_int(stmt, roomMessageIdIdx, room.roomMessageId_);
-        sqlite3_bind_int(stmt, createdAtIdx, room.createTime_);
-        sqlite3_bind_int(stmt, nodeLevelIdx, room.nodeLevel_);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            result = ChatResultCode::DBFAIL;
-        } else {
-            room.dbId_ = static_cast<uint32_t>(sqlite3_last_insert_rowid(db_));
-        }
+
+    RoomRecord record;
+    record.creatorId = room.creatorId_;
+    record.creatorName = room.creatorName_;
+    record.creatorAddress = room.creatorAddress_;
+    record.roomName = room.roomName_;
+    record.roomTopic = room.roomTopic_;
+    record.roomPassword = room.roomPassword_;
+    record.roomPrefix = room.roomPrefix_;
+    record.roomAddress = room.roomAddress_;
+    record.roomAttributes = room.roomAttributes_;
+    record.maxRoomSize = room.maxRoomSize_;
+    record.roomMessageId = room.roomMessageId_;
+    record.createTime = room.createTime_;
+    record.nodeLevel = room.nodeLevel_;
+
+    try {
+        room.dbId_ = roomStore_->InsertRoom(record);
+    } catch (const ChatResultException& e) {
+        LOG(ERROR) << "Failed to persist room " << FromWideString(room.roomAddress_) << ": " << e.message;
+        result = e.code;
     }
 
     return result;
@@ -175,34 +122,64 @@ ChatResultCode ChatRoomService::PersistNewRoom(ChatRoom& room) {
 
 std::vector<ChatRoom*> ChatRoomService::GetRoomSummaries(
     const std::u16string& startNode, const std::u16string& filter) {
+    auto cacheKey = std::make_pair(startNode, filter);
+
+    auto find_iter = summaryCache_.find(cacheKey);
+    if (find_iter != std::end(summaryCache_) && find_iter->second.generation == directoryGeneration_) {
+        return find_iter->second.rooms;
+    }
+
     std::vector<ChatRoom*> rooms;
 
-    for (auto& room : rooms_) {
-        auto& roomAddress = room->GetRoomAddress();
-        if (roomAddress.compare(0, startNode.length(), startNode) == 0) {
-            if (!room->IsPrivate()) {
-                rooms.push_back(room.get());
-            }
+    for (auto iter = roomDirectory_.lower_bound(startNode); iter != std::end(roomDirectory_); ++iter) {
+        auto& roomAddress = iter->first;
+        if (roomAddress.compare(0, startNode.length(), startNode) != 0) {
+            break;
+        }
+
+        auto room = iter->second;
+        if (room->IsPrivate()) {
+            continue;
+        }
+
+        // Substring match on the room name, not the address; see GetRoomSummaries.
+        if (!filter.empty() && room->GetRoomName().find(filter) == std::u16string::npos) {
+            continue;
         }
+
+        rooms.push_back(room);
+    }
+
+    if (summaryCache_.size() >= MAX_CACHED_ROOM_SUMMARIES) {
+        summaryCache_.clear();
     }
 
+    summaryCache_[cacheKey] = CachedRoomSummaries{directoryGeneration_, rooms};
+
     return rooms;
 }
 
 bool ChatRoomService::RoomExists(const std::u16string& roomAddress) const {
-    return std::find_if(std::begin(rooms_), std::end(rooms_), [roomAddress](auto& room) {
-        return roomAddress.compare(room->GetRoomAddress()) == 0;
-    }) != std::end(rooms_);
+    return roomsByAddress_.find(roomAddress) != std::end(roomsByAddress_);
 }
 
 ChatRoom* ChatRoomService::GetRoom(const std::u16string& roomAddress) {
     ChatRoom* room = nullptr;
 
-    auto find_iter = std::find_if(std::begin(rooms_), std::end(rooms_),
-        [roomAddress](auto& room) { return roomAddress.compare(room->GetRoomAddress()) == 0; });
+    auto find_iter = roomsByAddress_.find(roomAddress);
+    if (find_iter != std::end(roomsByAddress_)) {
+        room = find_iter->second;
+    }
+
+    return room;
+}
+
+ChatRoom* ChatRoomService::GetRoom(uint32_t roomId) {
+    ChatRoom* room = nullptr;
 
+    auto find_iter = rooms_.find(roomId);
     if (find_iter != std::end(rooms_)) {
-        room = find_iter->get();
+        room = find_iter->second.get();
     }
 
     return room;
@@ -211,209 +188,91 @@ ChatRoom* ChatRoomService::GetRoom(const std::u16string& roomAddress) {
 std::vector<ChatRoom*> ChatRoomService::GetJoinedRooms(const ChatAvatar * avatar) {
     std::vector<ChatRoom*> rooms;
 
-    for (auto& room : rooms_) {
-        if (room->IsInRoom(avatar->GetAvatarId())) {
-            rooms.push_back(room.get());
-        }
+    auto find_iter = joinedRooms_.find(avatar->GetAvatarId());
+    if (find_iter != std::end(joinedRooms_)) {
+        rooms.assign(std::begin(find_iter->second), std::end(find_iter->second));
     }
 
     return rooms;
 }
 
-void ChatRoomService::DeleteRoom(ChatRoom* room) {
-    sqlite3_stmt* stmt;
-    char sql[] = "DELETE FROM room WHERE id = @id";
+ChatRoom* ChatRoomService::TrackRoom(std::unique_ptr<ChatRoom> room) {
+    auto roomPtr = room.get();
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomsByAddress_[roomPtr->GetRoomAddress()] = roomPtr;
+    roomDirectory_[roomPtr->GetRoomAddress()] = roomPtr;
+    ++directoryGeneration_;
+    rooms_[roomPtr->GetRoomId()] = std::move(room);
 
-    int idIdx = sqlite3_bind_parameter_index(stmt, "@id");
-    sqlite3_bind_int(stmt, idIdx, room->dbId_);
+    return roomPtr;
+}
 
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+void ChatRoomService::OnEnterRoom(ChatRoom* room, uint32_t avatarId) {
+    joinedRooms_[avatarId].insert(room);
 }
 
-void ChatRoomService::LoadModerators(ChatRoom * room) {
-    sqlite3_stmt* stmt;
-    char sql[] = "SELECT moderator_avatar_id FROM room_moderator WHERE room_id = @room_id";
+void ChatRoomService::OnLeaveRoom(ChatRoom* room, uint32_t avatarId) {
+    auto find_iter = joinedRooms_.find(avatarId);
+    if (find_iter != std::end(joinedRooms_)) {
+        find_iter->second.erase(room);
 
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
+        if (find_iter->second.empty()) {
+            joinedRooms_.erase(find_iter);
+        }
     }
+}
 
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-    sqlite3_bind_int(stmt, roomIdIdx, room->GetRoomId());
+void ChatRoomService::DeleteRoom(ChatRoom* room) {
+    roomStore_->DeleteRoom(room->dbId_);
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        uint32_t moderatorId = sqlite3_column_int(stmt, 0);
-        room->moderators_.push_back(avatarService_->GetAvatar(moderatorId));
+void ChatRoomService::LoadModerators(ChatRoom * room) {
+    for (auto moderatorId : roomStore_->LoadRoomMembers(RoomRole::MODERATOR, room->GetRoomId())) {
+        auto avatar = avatarService_->GetAvatar(moderatorId);
+        if (avatar) {
+            room->AddMember(room->moderators_, avatar);
+        }
     }
 }
 
 void ChatRoomService::PersistModerator(uint32_t moderatorId, uint32_t roomId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "INSERT OR IGNORE INTO room_moderator (moderator_avatar_id, room_id) VALUES (@moderator_avatar_id, @room_id)";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int moderatorAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@moderator_avatar_id");
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-
-    sqlite3_bind_int(stmt, moderatorAvatarIdIdx, moderatorId);
-    sqlite3_bind_int(stmt, roomIdIdx, roomId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomStore_->AddRoomMember(RoomRole::MODERATOR, roomId, moderatorId);
 }
 
 void ChatRoomService::DeleteModerator(uint32_t moderatorId, uint32_t roomId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "DELETE FROM room_moderator WHERE moderator_avatar_id = @moderator_avatar_id AND room_id = @room_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int moderatorAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@moderator_avatar_id");
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-
-    sqlite3_bind_int(stmt, moderatorAvatarIdIdx, moderatorId);
-    sqlite3_bind_int(stmt, roomIdIdx, roomId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomStore_->RemoveRoomMember(RoomRole::MODERATOR, roomId, moderatorId);
 }
 
 void ChatRoomService::LoadAdministrators(ChatRoom * room) {
-    sqlite3_stmt* stmt;
-    char sql[] = "SELECT administrator_avatar_id FROM room_administrator WHERE room_id = @room_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-    sqlite3_bind_int(stmt, roomIdIdx, room->GetRoomId());
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        uint32_t administratorId = sqlite3_column_int(stmt, 0);
-        room->administrators_.push_back(avatarService_->GetAvatar(administratorId));
+    for (auto administratorId : roomStore_->LoadRoomMembers(RoomRole::ADMINISTRATOR, room->GetRoomId())) {
+        auto avatar = avatarService_->GetAvatar(administratorId);
+        if (avatar) {
+            room->AddMember(room->administrators_, avatar);
+        }
     }
 }
 
 void ChatRoomService::PersistAdministrator(uint32_t administratorId, uint32_t roomId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "INSERT OR IGNORE INTO room_administrator (administrator_avatar_id, room_id) VALUES (@administrator_avatar_id, @room_id)";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int administratorAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@administrator_avatar_id");
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-
-    sqlite3_bind_int(stmt, administratorAvatarIdIdx, administratorId);
-    sqlite3_bind_int(stmt, roomIdIdx, roomId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomStore_->AddRoomMember(RoomRole::ADMINISTRATOR, roomId, administratorId);
 }
 
 void ChatRoomService::DeleteAdministrator(uint32_t administratorId, uint32_t roomId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "DELETE FROM room_administrator WHERE administrator_avatar_id = @administrator_avatar_id AND room_id = @room_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int administratorAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@administrator_avatar_id");
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-
-    sqlite3_bind_int(stmt, administratorAvatarIdIdx, administratorId);
-    sqlite3_bind_int(stmt, roomIdIdx, roomId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomStore_->RemoveRoomMember(RoomRole::ADMINISTRATOR, roomId, administratorId);
 }
 
 void ChatRoomService::LoadBanned(ChatRoom * room) {
-    sqlite3_stmt* stmt;
-    char sql[] = "SELECT banned_avatar_id FROM room_ban WHERE room_id = @room_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-    sqlite3_bind_int(stmt, roomIdIdx, room->GetRoomId());
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        uint32_t bannedId = sqlite3_column_int(stmt, 0);
-        room->banned_.push_back(avatarService_->GetAvatar(bannedId));
+    for (auto bannedId : roomStore_->LoadRoomMembers(RoomRole::BANNED, room->GetRoomId())) {
+        auto avatar = avatarService_->GetAvatar(bannedId);
+        if (avatar) {
+            room->AddMember(room->banned_, avatar);
+        }
     }
 }
 
 void ChatRoomService::PersistBanned(uint32_t bannedId, uint32_t roomId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "INSERT OR IGNORE INTO room_ban (banned_avatar_id, room_id) VALUES (@banned_avatar_id, @room_id)";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int bannedAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@moderator_avatar_id");
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-
-    sqlite3_bind_int(stmt, bannedAvatarIdIdx, bannedId);
-    sqlite3_bind_int(stmt, roomIdIdx, roomId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomStore_->AddRoomMember(RoomRole::BANNED, roomId, bannedId);
 }
 
 void ChatRoomService::DeleteBanned(uint32_t bannedId, uint32_t roomId) {
-    sqlite3_stmt* stmt;
-    char sql[] = "DELETE FROM room_ban WHERE banned_avatar_id = @banned_avatar_id AND room_id = @room_id";
-
-    auto result = sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-    if (result != SQLITE_OK) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
-
-    int bannedAvatarIdIdx = sqlite3_bind_parameter_index(stmt, "@banned_avatar_id");
-    int roomIdIdx = sqlite3_bind_parameter_index(stmt, "@room_id");
-
-    sqlite3_bind_int(stmt, bannedAvatarIdIdx, bannedId);
-    sqlite3_bind_int(stmt, roomIdIdx, roomId);
-
-    result = sqlite3_step(stmt);
-    if (result != SQLITE_DONE) {
-        throw SQLite3Exception{result, sqlite3_errmsg(db_)};
-    }
+    roomStore_->RemoveRoomMember(RoomRole::BANNED, roomId, bannedId);
 }
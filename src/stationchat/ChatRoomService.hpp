@@ -3,21 +3,23 @@
 
 #include "ChatEnums.hpp"
 #include "ChatRoom.hpp"
+#include "ChatStorage.hpp"
 
 #include <boost/optional.hpp>
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-struct sqlite3;
-
 class ChatAvatarService;
 
 class ChatRoomService {
 public:
-    ChatRoomService(ChatAvatarService* avatarService, sqlite3* db);
+    ChatRoomService(ChatAvatarService* avatarService, RoomStore* roomStore);
     ~ChatRoomService();
 
     void LoadRoomsFromStorage(const std::u16string& baseAddress);
@@ -31,16 +33,26 @@ public:
 
     ChatResultCode PersistNewRoom(ChatRoom& avatar);
 
+    /** Lists the public rooms whose address starts with startNode. A non-empty
+     * filter keeps only rooms whose name contains it (a case-sensitive substring
+     * match); the client protocol passes the filter through without defining
+     * its semantics.
+     */
     std::vector<ChatRoom*> GetRoomSummaries(
         const std::u16string& startNode, const std::u16string& filter = u"");
 
     bool RoomExists(const std::u16string& roomAddress) const;
     ChatRoom* GetRoom(const std::u16string& roomAddress);
+    ChatRoom* GetRoom(uint32_t roomId);
 
     std::vector<ChatRoom*> GetJoinedRooms(const ChatAvatar* avatar);
 
 private:
     friend class ChatRoom;
+    ChatRoom* TrackRoom(std::unique_ptr<ChatRoom> room);
+    void OnEnterRoom(ChatRoom* room, uint32_t avatarId);
+    void OnLeaveRoom(ChatRoom* room, uint32_t avatarId);
+
     void DeleteRoom(ChatRoom* room);
     void LoadModerators(ChatRoom* room);
     void PersistModerator(uint32_t moderatorId, uint32_t roomId);
@@ -53,7 +65,25 @@ private:
     void DeleteBanned(uint32_t bannedId, uint32_t roomId);
 
     uint32_t nextRoomId_ = 0;
-    std::vector<std::unique_ptr<ChatRoom>> rooms_;
+    std::unordered_map<uint32_t, std::unique_ptr<ChatRoom>> rooms_;
+    std::unordered_map<std::u16string, ChatRoom*> roomsByAddress_;
+
+    // Ordered view of the room addresses so startNode queries are a range scan.
+    std::map<std::u16string, ChatRoom*> roomDirectory_;
+    uint64_t directoryGeneration_ = 0;
+
+    struct CachedRoomSummaries {
+        uint64_t generation;
+        std::vector<ChatRoom*> rooms;
+    };
+
+    // (startNode, filter) -> last result, valid while its generation is current.
+    // The filter is keyed verbatim since it is a case-sensitive substring match
+    // on the room name.
+    std::map<std::pair<std::u16string, std::u16string>, CachedRoomSummaries> summaryCache_;
+
+    // avatar id -> rooms the avatar is currently in
+    std::unordered_map<uint32_t, std::unordered_set<ChatRoom*>> joinedRooms_;
     ChatAvatarService* avatarService_;
-    sqlite3* db_;
+    RoomStore* roomStore_;
 };
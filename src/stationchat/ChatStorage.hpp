@@ -0,0 +1,134 @@
+
+#pragma once
+
+#include "PersistentMessage.hpp"
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* Storage interfaces behind the chat services.
+ *
+ * The services keep the authoritative chat state in memory and only use a
+ * store to load that state and to record changes to it. Implementations may
+ * defer writes, but must return their own earlier writes from later reads.
+ * Stores are only used from the thread that owns the services.
+ */
+
+struct AvatarRecord {
+    uint32_t avatarId = 0;
+    uint32_t userId = 0;
+    std::u16string name;
+    std::u16string address;
+    uint32_t attributes = 0;
+};
+
+struct FriendRecord {
+    uint32_t avatarId = 0;
+    uint32_t friendAvatarId = 0;
+    std::u16string comment;
+};
+
+struct IgnoreRecord {
+    uint32_t avatarId = 0;
+    uint32_t ignoreAvatarId = 0;
+};
+
+struct RoomRecord {
+    uint32_t roomId = 0;
+    uint32_t creatorId = 0;
+    std::u16string creatorName;
+    std::u16string creatorAddress;
+    std::u16string roomName;
+    std::u16string roomTopic;
+    std::u16string roomPassword;
+    std::u16string roomPrefix;
+    std::u16string roomAddress;
+    uint32_t roomAttributes = 0;
+    uint32_t maxRoomSize = 0;
+    uint32_t roomMessageId = 0;
+    uint32_t createTime = 0;
+    uint32_t nodeLevel = 0;
+};
+
+/** The per-room avatar lists that are kept in storage. */
+enum class RoomRole {
+    ADMINISTRATOR,
+    MODERATOR,
+    BANNED
+};
+
+class AvatarStore {
+public:
+    virtual ~AvatarStore() = default;
+
+    virtual boost::optional<AvatarRecord> LoadAvatar(uint32_t avatarId) = 0;
+    virtual boost::optional<AvatarRecord> LoadAvatar(
+        const std::u16string& name, const std::u16string& address) = 0;
+
+    /** Visits every stored avatar, used to warm load the avatar cache. */
+    virtual void ForEachAvatar(const std::function<void(const AvatarRecord&)>& visitor) = 0;
+
+    /** Stores a new avatar and returns the id assigned to it. Throws a
+     * ChatResultException with DBFAIL if the avatar could not be stored, e.g.
+     * when one with the same name and address already exists.
+     */
+    virtual uint32_t InsertAvatar(const AvatarRecord& avatar) = 0;
+    virtual void UpdateAvatar(const AvatarRecord& avatar) = 0;
+    virtual void DeleteAvatar(uint32_t avatarId) = 0;
+};
+
+class ContactStore {
+public:
+    virtual ~ContactStore() = default;
+
+    virtual std::vector<FriendRecord> LoadFriends(uint32_t avatarId) = 0;
+    virtual std::vector<IgnoreRecord> LoadIgnores(uint32_t avatarId) = 0;
+
+    virtual void ForEachFriend(const std::function<void(const FriendRecord&)>& visitor) = 0;
+    virtual void ForEachIgnore(const std::function<void(const IgnoreRecord&)>& visitor) = 0;
+
+    virtual void AddFriend(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) = 0;
+    virtual void UpdateFriendComment(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) = 0;
+    virtual void RemoveFriend(uint32_t avatarId, uint32_t friendAvatarId) = 0;
+
+    virtual void AddIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) = 0;
+    virtual void RemoveIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) = 0;
+};
+
+class RoomStore {
+public:
+    virtual ~RoomStore() = default;
+
+    /** Returns the stored rooms whose address starts with baseAddress. */
+    virtual std::vector<RoomRecord> LoadRooms(const std::u16string& baseAddress) = 0;
+
+    /** Stores a new room and returns the id assigned to it. Throws a
+     * ChatResultException with DBFAIL if the room could not be stored.
+     */
+    virtual uint32_t InsertRoom(const RoomRecord& room) = 0;
+    virtual void DeleteRoom(uint32_t roomId) = 0;
+
+    virtual std::vector<uint32_t> LoadRoomMembers(RoomRole role, uint32_t roomId) = 0;
+    virtual void AddRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) = 0;
+    virtual void RemoveRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) = 0;
+};
+
+class MailStore {
+public:
+    virtual ~MailStore() = default;
+
+    /** Stores a new message and returns the id assigned to it. */
+    virtual uint32_t InsertMessage(const PersistentMessage& message) = 0;
+
+    /** Returns the headers of an avatar's new, unread and read messages. */
+    virtual std::vector<PersistentHeader> LoadMessageHeaders(uint32_t avatarId) = 0;
+    virtual boost::optional<PersistentMessage> LoadMessage(uint32_t avatarId, uint32_t messageId) = 0;
+
+    virtual void UpdateMessageStatus(uint32_t avatarId, uint32_t messageId, PersistentState status) = 0;
+    virtual void UpdateMessageStatus(
+        uint32_t avatarId, const std::u16string& category, PersistentState status) = 0;
+};
@@ -1,222 +1,152 @@
 #include "GatewayClient.hpp"
+#include "GatewayNode.hpp"
 
 GatewayClient::GatewayClient(UdpConnection* connection, GatewayNode* node)
-    : NodeClient(connection), node_{node}, avatarService_{node->GetAvatarService()}, roomService_{node->GetRoomService()}, messageService_{node->GetMessageService()} {
+    : NodeClient(connection, node->GetBufferPool()), node_{node}, avatarService_{node->GetAvatarService()}, roomService_{node->GetRoomService()}, messageService_{node->GetMessageService()} {
     connection->SetHandler(this);
+}
+
+GatewayClient::~GatewayClient() {}
+
+void GatewayClient::OnIncoming(BufferReader& istream) {
+    ChatRequestType request_type = ::read<ChatRequestType>(istream);
 
-    // Initialize MySQL connection
-    conn_ = mysql_init(nullptr);
-    if (conn_ == nullptr) {
-        LOG(ERROR) << "mysql_init() failed";
+    auto& dispatchTable = GetDispatchTable();
+    auto index = static_cast<size_t>(request_type);
+    if (index >= dispatchTable.size() || !dispatchTable[index]) {
+        LOG(INFO) << "Unknown request type received: " << static_cast<uint16_t>(request_type);
         return;
     }
 
-    if (mysql_real_connect(conn_, "localhost", "user", "password", "database", 0, nullptr, 0) == nullptr) {
-        LOG(ERROR) << "mysql_real_connect() failed: " << mysql_error(conn_);
-        mysql_close(conn_);
-    }
+    (this->*dispatchTable[index])(istream);
 }
 
-GatewayClient::~GatewayClient() {
-    if (conn_ != nullptr) {
-        mysql_close(conn_);
-    }
-}
+template <typename... HandlerTs>
+GatewayClient::DispatchTable GatewayClient::BuildDispatchTable() {
+    DispatchTable dispatchTable{};
 
-void GatewayClient::OnIncoming(std::istringstream& istream) {
-    ChatRequestType request_type = ::read<ChatRequestType>(istream);
+    // Registers each handler under the request type declared by its request.
+    using expand = int[];
+    (void)expand{0, (dispatchTable[static_cast<size_t>(typename HandlerTs::RequestType{}.type)]
+                         = &GatewayClient::HandleIncomingMessage<HandlerTs>, 0)...};
 
-    switch (request_type) {
-    case ChatRequestType::LOGINAVATAR:
-        HandleIncomingMessage<LoginAvatar>(istream);
-        break;
-    case ChatRequestType::LOGOUTAVATAR:
-        HandleIncomingMessage<LogoutAvatar>(istream);
-        break;
-    case ChatRequestType::CREATEROOM:
-        HandleIncomingMessage<CreateRoom>(istream);
-        break;
-    case ChatRequestType::DESTROYROOM:
-        HandleIncomingMessage<DestroyRoom>(istream);
-        break;
-    case ChatRequestType::SENDINSTANTMESSAGE:
-        HandleIncomingMessage<SendInstantMessage>(istream);
-        break;
-    case ChatRequestType::SENDROOMMESSAGE:
-        HandleIncomingMessage<SendRoomMessage>(istream);
-        break;
-    case ChatRequestType::ADDFRIEND:
-        HandleIncomingMessage<AddFriend>(istream);
-        break;
-    case ChatRequestType::REMOVEFRIEND:
-        HandleIncomingMessage<RemoveFriend>(istream);
-        break;
-    case ChatRequestType::FRIENDSTATUS:
-        HandleIncomingMessage<FriendStatus>(istream);
-        break;
-    case ChatRequestType::ADDIGNORE:
-        HandleIncomingMessage<AddIgnore>(istream);
-        break;
-    case ChatRequestType::REMOVEIGNORE:
-        HandleIncomingMessage<RemoveIgnore>(istream);
-        break;
-    case ChatRequestType::ENTERROOM:
-        HandleIncomingMessage<EnterRoom>(istream);
-        break;
-    case ChatRequestType::LEAVEROOM:
-        HandleIncomingMessage<LeaveRoom>(istream);
-        break;
-    case ChatRequestType::ADDMODERATOR:
-        HandleIncomingMessage<AddModerator>(istream);
-        break;
-    case ChatRequestType::REMOVEMODERATOR:
-        HandleIncomingMessage<RemoveModerator>(istream);
-        break;
-    case ChatRequestType::ADDBAN:
-        HandleIncomingMessage<AddBan>(istream);
-        break;
-    case ChatRequestType::REMOVEBAN:
-        HandleIncomingMessage<RemoveBan>(istream);
-        break;
-    case ChatRequestType::ADDINVITE:
-        HandleIncomingMessage<AddInvite>(istream);
-        break;
-    case ChatRequestType::REMOVEINVITE:
-        HandleIncomingMessage<RemoveInvite>(istream);
-        break;
-    case ChatRequestType::KICKAVATAR:
-        HandleIncomingMessage<KickAvatar>(istream);
-        break;
-    case ChatRequestType::GETROOM:
-        HandleIncomingMessage<GetRoom>(istream);
-        break;
-    case ChatRequestType::GETROOMSUMMARIES:
-        HandleIncomingMessage<GetRoomSummaries>(istream);
-        break;
-    case ChatRequestType::SENDPERSISTENTMESSAGE:
-        HandleIncomingMessage<SendPersistentMessage>(istream);
-        break;
-    case ChatRequestType::GETPERSISTENTHEADERS:
-        HandleIncomingMessage<GetPersistentHeaders>(istream);
-        break;
-    case ChatRequestType::GETPERSISTENTMESSAGE:
-        HandleIncomingMessage<GetPersistentMessage>(istream);
-        break;
-    case ChatRequestType::UPDATEPERSISTENTMESSAGE:
-        HandleIncomingMessage<UpdatePersistentMessage>(istream);
-        break;
-    case ChatRequestType::UPDATEPERSISTENTMESSAGES:
-        HandleIncomingMessage<UpdatePersistentMessages>(istream);
-        break;
-    case ChatRequestType::IGNORESTATUS:
-        HandleIncomingMessage<IgnoreStatus>(istream);
-        break;
-    case ChatRequestType::FAILOVER_RELOGINAVATAR:
-        HandleIncomingMessage<FailoverReLoginAvatar>(istream);
-        break;
-    case ChatRequestType::SETAPIVERSION:
-        HandleIncomingMessage<SetApiVersion>(istream);
-        break;
-    case ChatRequestType::SETAVATARATTRIBUTES:
-        HandleIncomingMessage<SetAvatarAttributes>(istream);
-        break;
-    case ChatRequestType::GETANYAVATAR:
-        HandleIncomingMessage<GetAnyAvatar>(istream);
-        break;
-    default:
-        LOG(INFO) << "Unknown request type received: " << static_cast<uint16_t>(request_type);
-        break;
-    }
+    return dispatchTable;
 }
 
-template <typename T>
-void GatewayClient::HandleIncomingMessage(std::istringstream& istream) {
-    T message;
-    message.Deserialize(istream);
-    // Process message using MySQL queries
-    // Example:
-    std::string query = "SELECT * FROM avatars WHERE avatar_id = " + std::to_string(message.GetAvatarId());
-    if (mysql_query(conn_, query.c_str())) {
-        LOG(ERROR) << "MySQL query failed: " << mysql_error(conn_);
-    } else {
-        MYSQL_RES* res = mysql_store_result(conn_);
-        if (res) {
-            MYSQL_ROW row;
-            while ((row = mysql_fetch_row(res)) != nullptr) {
-                // Process the row data
-            }
-            mysql_free_result(res);
-        } else {
-            LOG(ERROR) << "mysql_store_result() failed: " << mysql_error(conn_);
-        }
+const GatewayClient::DispatchTable& GatewayClient::GetDispatchTable() {
+    static const auto dispatchTable = BuildDispatchTable<
+        LoginAvatar,
+        LogoutAvatar,
+        CreateRoom,
+        DestroyRoom,
+        SendInstantMessage,
+        SendRoomMessage,
+        AddFriend,
+        RemoveFriend,
+        FriendStatus,
+        AddIgnore,
+        RemoveIgnore,
+        EnterRoom,
+        LeaveRoom,
+        AddModerator,
+        RemoveModerator,
+        AddBan,
+        RemoveBan,
+        AddInvite,
+        RemoveInvite,
+        KickAvatar,
+        GetRoom,
+        GetRoomSummaries,
+        SendPersistentMessage,
+        GetPersistentHeaders,
+        GetPersistentMessage,
+        UpdatePersistentMessage,
+        UpdatePersistentMessages,
+        IgnoreStatus,
+        FailoverReLoginAvatar,
+        SetApiVersion,
+        SetAvatarAttributes,
+        GetAnyAvatar>();
+
+    return dispatchTable;
+}
+
+template <typename HandlerT>
+void GatewayClient::HandleIncomingMessage(BufferReader& istream) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto request = ::read<typename HandlerT::RequestType>(istream);
+    typename HandlerT::ResponseType response{request.track};
+
+    try {
+        HandlerT(this, request, response);
+    } catch (const ChatResultException& e) {
+        response.result = e.code;
+        LOG(ERROR) << "ChatAPI Error: [" << static_cast<uint32_t>(e.code) << "] " << e.message;
     }
+
+    auto buffer = node_->GetBufferPool().Acquire();
+    write(*buffer, response);
+    SendEncoded(*buffer);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    node_->GetRequestMetrics(request.type).Record(istream.length(), buffer->length(), response.result, elapsed);
 }
 
 void GatewayClient::SendFriendLoginUpdate(const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar) {
-    node_->SendTo(srcAvatar->GetAddress(), MFriendLogin{destAvatar, destAvatar->GetAddress(), srcAvatar->GetAvatarId(), destAvatar->GetStatusMessage()});
+    node_->SendTo(srcAvatar->GetAddressAtom(), MFriendLogin{destAvatar, destAvatar->GetAddress(), srcAvatar->GetAvatarId(), destAvatar->GetStatusMessage()});
 }
 
 void GatewayClient::SendFriendLoginUpdates(const ChatAvatar* avatar) {
-    auto& onlineAvatars = avatarService_->GetOnlineAvatars();
-    for (auto onlineAvatar : onlineAvatars) {
-        if (onlineAvatar->IsFriend(avatar)) {
-            SendFriendLoginUpdate(onlineAvatar, avatar);
-        }
+    for (auto onlineAvatar : avatarService_->GetOnlineAvatarsListingFriend(avatar)) {
+        SendFriendLoginUpdate(onlineAvatar, avatar);
     }
 
+    // Only online friends are notified, and those are always resident, so
+    // offline contacts are never loaded here.
     for (auto& contact : avatar->GetFriendList()) {
-        if (contact.frnd->IsOnline()) {
-            Send(MFriendLogin{contact.frnd, contact.frnd->GetAddress(), avatar->GetAvatarId(), contact.frnd->GetStatusMessage()});
+        auto frnd = avatarService_->GetOnlineAvatar(contact.frndId);
+        if (frnd) {
+            Send(MFriendLogin{frnd, frnd->GetAddress(), avatar->GetAvatarId(), frnd->GetStatusMessage()});
         }
     }
 }
 
 void GatewayClient::SendFriendLogoutUpdates(const ChatAvatar* avatar) {
-    auto& onlineAvatars = avatarService_->GetOnlineAvatars();
-    for (auto onlineAvatar : onlineAvatars) {
-        if (onlineAvatar->IsFriend(avatar)) {
-            node_->SendTo(onlineAvatar->GetAddress(), MFriendLogout{avatar, avatar->GetAddress(), onlineAvatar->GetAvatarId()});
-        }
+    for (auto onlineAvatar : avatarService_->GetOnlineAvatarsListingFriend(avatar)) {
+        node_->SendTo(onlineAvatar->GetAddressAtom(), MFriendLogout{avatar, avatar->GetAddress(), onlineAvatar->GetAvatarId()});
     }
 }
 
-void GatewayClient::SendDestroyRoomUpdate(const ChatAvatar* srcAvatar, uint32_t roomId, std::vector<std::u16string> targets) {
-    for (auto& address : targets) {
-        node_->SendTo(address, MDestroyRoom{srcAvatar, roomId});
-    }
+void GatewayClient::SendDestroyRoomUpdate(const ChatAvatar* srcAvatar, uint32_t roomId, const std::vector<AddressAtom>& targets) {
+    node_->SendToAll(targets, MDestroyRoom{srcAvatar, roomId});
 }
 
 void GatewayClient::SendInstantMessageUpdate(const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar, const std::u16string& message, const std::u16string& oob) {
-    node_->SendTo(destAvatar->GetAddress(), MInstantMessage{srcAvatar, destAvatar->GetAvatarId(), message, oob});
+    node_->SendTo(destAvatar->GetAddressAtom(), MInstantMessage{srcAvatar, destAvatar->GetAvatarId(), message, oob});
 }
 
 void GatewayClient::SendRoomMessageUpdate(const ChatAvatar* srcAvatar, const ChatRoom* room, uint32_t messageId, const std::u16string& message, const std::u16string& oob) {
-    auto connectedAddresses = room->GetConnectedAddresses();
-    for (auto& address : connectedAddresses) {
-        node_->SendTo(address, MRoomMessage{srcAvatar, room->GetRoomId(), room->GetAvatarIds(srcAvatar), message, oob, messageId});
-    }
+    // Filter the recipients and encode the message once, every game server
+    // connected to the room receives the same bytes.
+    node_->SendToAll(room->GetConnectedAddressCounts(),
+        MRoomMessage{srcAvatar, room->GetRoomId(), room->GetAvatarIds(srcAvatar), message, oob, messageId});
 }
 
 void GatewayClient::SendEnterRoomUpdate(const ChatAvatar* srcAvatar, const ChatRoom* room) {
-    for (const auto& address : room->GetConnectedAddresses()) {
-        node_->SendTo(address, MEnterRoom{srcAvatar, room->GetRoomId()});
-    }
+    node_->SendToAll(room->GetConnectedAddressCounts(), MEnterRoom{srcAvatar, room->GetRoomId()});
 }
 
-void GatewayClient::SendLeaveRoomUpdate(const std::vector<std::u16string>& addresses, uint32_t srcAvatarId, uint32_t roomId) {
-    for (const auto& address : addresses) {
-        node_->SendTo(address, MLeaveRoom{srcAvatarId, roomId});
-    }
+void GatewayClient::SendLeaveRoomUpdate(const std::vector<AddressAtom>& addresses, uint32_t srcAvatarId, uint32_t roomId) {
+    node_->SendToAll(addresses, MLeaveRoom{srcAvatarId, roomId});
 }
 
 void GatewayClient::SendPersistentMessageUpdate(const ChatAvatar* destAvatar, const PersistentHeader& header) {
     if (destAvatar) {
-        node_->SendTo(destAvatar->GetAddress(), MPersistentMessage{destAvatar->GetAvatarId(), header});
+        node_->SendTo(destAvatar->GetAddressAtom(), MPersistentMessage{destAvatar->GetAvatarId(), header});
     }
 }
 
-void GatewayClient::SendKickAvatarUpdate(const std::vector<std::u16string>& addresses, const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar, const ChatRoom* room) {
-    for (const auto& address : addresses) {
-        node_->SendTo(address, MKickAvatar{srcAvatar, destAvatar, room->GetRoomName(), room->GetRoomAddress()});
-    }
+void GatewayClient::SendKickAvatarUpdate(const std::vector<AddressAtom>& addresses, const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar, const ChatRoom* room) {
+    node_->SendToAll(addresses, MKickAvatar{srcAvatar, destAvatar, room->GetRoomName(), room->GetRoomAddress()});
 }
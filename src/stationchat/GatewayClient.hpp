@@ -2,9 +2,10 @@
 #include "ChatAvatarService.hpp"
 #include "ChatEnums.hpp"
 #include "ChatRoomService.hpp"
-#include "GatewayNode.hpp"
 #include "Message.hpp"
+#include "NodeClient.hpp"
 #include "PersistentMessageService.hpp"
+#include "RequestMetrics.hpp"
 #include "protocol/AddBan.hpp"
 #include "protocol/AddFriend.hpp"
 #include "protocol/AddIgnore.hpp"
@@ -38,33 +39,48 @@
 #include "protocol/UpdatePersistentMessage.hpp"
 #include "protocol/UpdatePersistentMessages.hpp"
 
-#include <mysql/mysql.h>
 #include "easylogging++.h"
 
+#include <array>
+
+class GatewayNode;
+
 class GatewayClient : public NodeClient {
 public:
     GatewayClient(UdpConnection* connection, GatewayNode* node);
     ~GatewayClient();
-    void OnIncoming(std::istringstream& istream);
 
-private:
-    GatewayNode* node_;
-    ChatAvatarService* avatarService_;
-    ChatRoomService* roomService_;
-    PersistentMessageService* messageService_;
-    MYSQL* conn_;
-
-    template <typename T>
-    void HandleIncomingMessage(std::istringstream& istream);
+    GatewayNode* GetNode() { return node_; }
 
     void SendFriendLoginUpdate(const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar);
     void SendFriendLoginUpdates(const ChatAvatar* avatar);
     void SendFriendLogoutUpdates(const ChatAvatar* avatar);
-    void SendDestroyRoomUpdate(const ChatAvatar* srcAvatar, uint32_t roomId, std::vector<std::u16string> targets);
+    void SendDestroyRoomUpdate(const ChatAvatar* srcAvatar, uint32_t roomId, const std::vector<AddressAtom>& targets);
     void SendInstantMessageUpdate(const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar, const std::u16string& message, const std::u16string& oob);
     void SendRoomMessageUpdate(const ChatAvatar* srcAvatar, const ChatRoom* room, uint32_t messageId, const std::u16string& message, const std::u16string& oob);
     void SendEnterRoomUpdate(const ChatAvatar* srcAvatar, const ChatRoom* room);
-    void SendLeaveRoomUpdate(const std::vector<std::u16string>& addresses, uint32_t srcAvatarId, uint32_t roomId);
+    void SendLeaveRoomUpdate(const std::vector<AddressAtom>& addresses, uint32_t srcAvatarId, uint32_t roomId);
     void SendPersistentMessageUpdate(const ChatAvatar* destAvatar, const PersistentHeader& header);
-    void SendKickAvatarUpdate(const std::vector<std::u16string>& addresses, const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar, const ChatRoom* room);
+    void SendKickAvatarUpdate(const std::vector<AddressAtom>& addresses, const ChatAvatar* srcAvatar, const ChatAvatar* destAvatar, const ChatRoom* room);
+
+private:
+    void OnIncoming(BufferReader& istream) override;
+
+    GatewayNode* node_;
+    ChatAvatarService* avatarService_;
+    ChatRoomService* roomService_;
+    PersistentMessageService* messageService_;
+
+    using RequestHandler = void (GatewayClient::*)(BufferReader&);
+    using DispatchTable = std::array<RequestHandler, GATEWAY_REQUEST_TYPE_COUNT>;
+
+    template <typename... HandlerTs>
+    static DispatchTable BuildDispatchTable();
+    static const DispatchTable& GetDispatchTable();
+
+    /** Reads a request, runs its handler and sends the response, recording
+     * the exchange in the node's request metrics.
+     */
+    template <typename HandlerT>
+    void HandleIncomingMessage(BufferReader& istream);
 };
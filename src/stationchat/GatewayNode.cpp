@@ -1,35 +1,167 @@
+
 #include "GatewayNode.hpp"
+
+#include "InMemoryChatStorage.hpp"
+#include "PersistenceWorker.hpp"
+#include "SQLite3.hpp"
+#include "SQLiteChatStorage.hpp"
+#include "StationChatConfig.hpp"
+#include "StringUtils.hpp"
+
 #include "easylogging++.h"
 
-GatewayNode::GatewayNode()
-    : avatarService_(std::make_unique<ChatAvatarService>())
-    , roomService_(std::make_unique<ChatRoomService>())
-    , messageService_(std::make_unique<PersistentMessageService>())
-    , udpLibrary_(std::make_unique<UdpLibrary>()) {
-    connection_ = udpLibrary_->CreateConnection();
-    InitializeServices();
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+const std::chrono::minutes REQUEST_METRICS_INTERVAL{5};
+}
+
+GatewayNode::GatewayNode(StationChatConfig& config)
+    : Node(this, config.gatewayAddress, config.gatewayPort, config.bindToIp)
+    , config_{config} {
+    if (config_.warmLoadAvatars && config_.avatarCacheSize > 0) {
+        throw std::runtime_error("warm_load_avatars cannot be combined with a nonzero avatar_cache_size");
+    }
+
+    // The destructor does not run when construction fails part way, so
+    // whatever storage was opened by then is released here.
+    try {
+        if (config_.storageBackend == "sqlite") {
+            if (sqlite3_open(config_.chatDatabasePath.c_str(), &db_) != SQLITE_OK) {
+                throw SQLite3Exception{sqlite3_errcode(db_), sqlite3_errmsg(db_)};
+            }
+
+            // Reads share the database with the persistence worker's connection.
+            ApplySQLite3Settings(db_, config_.sqliteSettings);
+            LOG(INFO) << "SQLite settings: " << DescribeSQLite3Settings(db_);
+
+            auto migrations = MigrateChatDatabase(db_);
+            LOG(INFO) << "Database schema at version " << GetSQLite3UserVersion(db_) << ", " << migrations
+                      << " migrations applied";
+
+            if (config_.sqliteBenchmark) {
+                BenchmarkSQLiteStorage(config_.chatDatabasePath + ".benchmark", config_.sqliteSettings);
+            }
+
+            persistenceWorker_ = std::make_unique<PersistenceWorker>(
+                config_.chatDatabasePath, config_.sqliteSettings, config_.persistenceCommitInterval);
+
+            avatarStore_ = std::make_unique<SQLiteAvatarStore>(db_, persistenceWorker_.get());
+            contactStore_ = std::make_unique<SQLiteContactStore>(db_, persistenceWorker_.get());
+            roomStore_ = std::make_unique<SQLiteRoomStore>(db_, persistenceWorker_.get());
+            mailStore_ = std::make_unique<SQLiteMailStore>(db_, persistenceWorker_.get());
+        } else if (config_.storageBackend == "memory") {
+            LOG(WARNING) << "Using in-memory storage, chat data will not survive a restart";
+
+            avatarStore_ = std::make_unique<InMemoryAvatarStore>();
+            contactStore_ = std::make_unique<InMemoryContactStore>();
+            roomStore_ = std::make_unique<InMemoryRoomStore>();
+            mailStore_ = std::make_unique<InMemoryMailStore>();
+        } else {
+            throw std::runtime_error("Unknown storage backend: " + config_.storageBackend);
+        }
+
+        avatarService_ = std::make_unique<ChatAvatarService>(&addressTable_, avatarStore_.get(), contactStore_.get());
+        roomService_ = std::make_unique<ChatRoomService>(avatarService_.get(), roomStore_.get());
+        messageService_ = std::make_unique<PersistentMessageService>(mailStore_.get());
+
+        avatarService_->SetMaxCachedAvatars(config_.avatarCacheSize);
+        nextMetricsReport_ = std::chrono::steady_clock::now() + REQUEST_METRICS_INTERVAL;
+
+        if (config_.warmLoadAvatars) {
+            avatarService_->WarmLoadAvatars();
+        }
+    } catch (...) {
+        CloseStorage();
+        throw;
+    }
 }
 
 GatewayNode::~GatewayNode() {
-    // Resources are automatically cleaned up by unique_ptr
+    LogRequestMetrics();
+    LogRoutes();
+
+    CloseStorage();
 }
 
-void GatewayNode::InitializeServices() {
-    // Initialize your services here
-    avatarService_->Initialize();
-    roomService_->Initialize();
-    messageService_->Initialize();
+void GatewayNode::CloseStorage() {
+    messageService_.reset();
+    roomService_.reset();
+    avatarService_.reset();
+
+    mailStore_.reset();
+    roomStore_.reset();
+    contactStore_.reset();
+    avatarStore_.reset();
+
+    // Drains and commits any outstanding writes before the database closes.
+    persistenceWorker_.reset();
+
+    sqlite3_close(db_);
+    db_ = nullptr;
+}
+
+void GatewayNode::RegisterClientAddress(AddressAtom address, GatewayClient* client) {
+    if (address >= routes_.size()) {
+        routes_.resize(address + 1);
+    }
+
+    routes_[address].client = client;
 }
 
-void GatewayNode::CreateClient(const std::u16string& address) {
-    if (clients_.find(address) == clients_.end()) {
-        clients_[address] = std::make_unique<GatewayClient>(connection_.get(), this);
+void GatewayNode::OnClientDisconnected(GatewayClient* client) {
+    for (auto& route : routes_) {
+        if (route.client == client) {
+            route.client = nullptr;
+        }
     }
 }
 
-void GatewayNode::SendTo(const std::u16string& address, const Message& message) {
-    if (clients_.find(address) == clients_.end()) {
-        CreateClient(address);
+void GatewayNode::LogRoutes() const {
+    for (size_t address = 0; address < routes_.size(); ++address) {
+        auto& route = routes_[address];
+        if (route.sent > 0 || route.dropped > 0) {
+            LOG(INFO) << "Route " << FromWideString(addressTable_.GetAddress(static_cast<AddressAtom>(address)))
+                      << ": " << route.sent << " sent, " << route.dropped << " dropped";
+        }
+    }
+
+    LOG(INFO) << "Total dropped sends: " << droppedSends_;
+}
+
+void GatewayNode::OnTick() {
+    if (persistenceWorker_) {
+        persistenceWorker_->ReportFailures();
+    }
+
+    avatarService_->TrimCache();
+
+    if (std::chrono::steady_clock::now() >= nextMetricsReport_) {
+        LogRequestMetrics();
+        nextMetricsReport_ = std::chrono::steady_clock::now() + REQUEST_METRICS_INTERVAL;
+    }
+}
+
+void GatewayNode::LogRequestMetrics() const {
+    for (size_t type = 0; type < requestMetrics_.size(); ++type) {
+        auto& metrics = requestMetrics_[type];
+        if (metrics.calls == 0) {
+            continue;
+        }
+
+        std::ostringstream errors;
+        for (auto& error : metrics.errors) {
+            errors << " " << ToString(error.first) << "=" << error.second;
+        }
+
+        // Reports the upper bound of the bucket holding the median request.
+        size_t bucket = 0;
+        for (uint64_t seen = metrics.latency[0]; seen * 2 < metrics.calls; seen += metrics.latency[++bucket]) {
+        }
+
+        LOG(INFO) << "Request " << ToString(static_cast<ChatRequestType>(type)) << ": " << metrics.calls
+                  << " calls, " << metrics.bytesIn << " bytes in, " << metrics.bytesOut << " bytes out, median under "
+                  << (1u << bucket) << " us, errors:" << (errors.str().empty() ? " none" : errors.str());
     }
-    clients_[address]->Send(message);
 }
@@ -1,35 +1,144 @@
+
 #pragma once
 
+#include "AddressTable.hpp"
 #include "ChatAvatarService.hpp"
 #include "ChatRoomService.hpp"
-#include "PersistentMessageService.hpp"
-#include "UdpLibrary.hpp"
+#include "ChatStorage.hpp"
 #include "GatewayClient.hpp"
-#include "Message.hpp"
+#include "Node.hpp"
+#include "PersistentMessageService.hpp"
+#include "RequestMetrics.hpp"
 
-#include <unordered_map>
-#include <string>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+struct StationChatConfig;
+class PersistenceWorker;
 
-class GatewayNode {
+class GatewayNode : public Node<GatewayNode, GatewayClient> {
 public:
-    GatewayNode();
+    explicit GatewayNode(StationChatConfig& config);
     ~GatewayNode();
 
     ChatAvatarService* GetAvatarService() const { return avatarService_.get(); }
     ChatRoomService* GetRoomService() const { return roomService_.get(); }
     PersistentMessageService* GetMessageService() const { return messageService_.get(); }
+    StationChatConfig& GetConfig() { return config_; }
+
+    AddressTable& GetAddressTable() { return addressTable_; }
+
+    /** Routing state for one gateway address. */
+    struct Route {
+        GatewayClient* client = nullptr;
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+    };
+
+    void RegisterClientAddress(AddressAtom address, GatewayClient* client);
+
+    template <typename MessageT>
+    void SendTo(AddressAtom address, const MessageT& message) {
+        auto client = Resolve(address);
+        if (client) {
+            client->Send(message);
+        }
+    }
+
+    /** Serializes the message once and sends the encoded bytes to every
+     * address in the list.
+     */
+    template <typename MessageT>
+    void SendToAll(const std::vector<AddressAtom>& addresses, const MessageT& message) {
+        if (addresses.empty()) {
+            return;
+        }
+
+        auto buffer = GetBufferPool().Acquire();
+        write(*buffer, message);
 
-    void SendTo(const std::u16string& address, const Message& message);
+        for (auto address : addresses) {
+            auto client = Resolve(address);
+            if (client) {
+                client->SendEncoded(*buffer);
+            }
+        }
+    }
+
+    /** Sends to every gateway in a room's address counts without first copying
+     * the addresses out into a vector.
+     */
+    template <typename MessageT>
+    void SendToAll(const ChatRoom::AddressCounts& addresses, const MessageT& message) {
+        if (addresses.empty()) {
+            return;
+        }
+
+        auto buffer = GetBufferPool().Acquire();
+        write(*buffer, message);
+
+        for (const auto& address : addresses) {
+            auto client = Resolve(address.first);
+            if (client) {
+                client->SendEncoded(*buffer);
+            }
+        }
+    }
+
+    /** Handler metrics indexed by request type. */
+    const RequestMetricsTable& GetRequestMetrics() const { return requestMetrics_; }
+    RequestMetrics& GetRequestMetrics(ChatRequestType type) { return requestMetrics_[static_cast<size_t>(type)]; }
+
+    /** Routes indexed by address atom. */
+    const std::vector<Route>& GetRoutes() const { return routes_; }
+    uint64_t GetDroppedSends() const { return droppedSends_; }
 
 private:
+    void OnTick() override;
+    void OnClientDisconnected(GatewayClient* client) override;
+
+    /** Returns the client registered for the address and counts the send
+     * against its route. Sends to unknown or disconnected gateways are
+     * counted and dropped.
+     */
+    GatewayClient* Resolve(AddressAtom address) {
+        if (address >= routes_.size()) {
+            ++droppedSends_;
+            return nullptr;
+        }
+
+        auto& route = routes_[address];
+        if (!route.client) {
+            ++route.dropped;
+            ++droppedSends_;
+            return nullptr;
+        }
+
+        ++route.sent;
+        return route.client;
+    }
+
+    void CloseStorage();
+    void LogRoutes() const;
+    void LogRequestMetrics() const;
+
+    AddressTable addressTable_;
+
+    std::unique_ptr<PersistenceWorker> persistenceWorker_;
+    std::unique_ptr<AvatarStore> avatarStore_;
+    std::unique_ptr<ContactStore> contactStore_;
+    std::unique_ptr<RoomStore> roomStore_;
+    std::unique_ptr<MailStore> mailStore_;
     std::unique_ptr<ChatAvatarService> avatarService_;
     std::unique_ptr<ChatRoomService> roomService_;
     std::unique_ptr<PersistentMessageService> messageService_;
-    std::unordered_map<std::u16string, std::unique_ptr<GatewayClient>> clients_;
-    std::unique_ptr<UdpConnection> connection_;
-    std::unique_ptr<UdpLibrary> udpLibrary_;
-
-    void InitializeServices();
-    void CreateClient(const std::u16string& address);
+    std::vector<Route> routes_;
+    uint64_t droppedSends_ = 0;
+    RequestMetricsTable requestMetrics_;
+    std::chrono::steady_clock::time_point nextMetricsReport_;
+    StationChatConfig& config_;
+    sqlite3* db_ = nullptr;
 };
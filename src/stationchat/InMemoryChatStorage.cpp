@@ -0,0 +1,250 @@
+#include "InMemoryChatStorage.hpp"
+
+#include "ChatEnums.hpp"
+
+#include <algorithm>
+#include <limits>
+
+boost::optional<AvatarRecord> InMemoryAvatarStore::LoadAvatar(uint32_t avatarId) {
+    auto find_iter = avatars_.find(avatarId);
+    if (find_iter == std::end(avatars_)) {
+        return boost::none;
+    }
+
+    return find_iter->second;
+}
+
+boost::optional<AvatarRecord> InMemoryAvatarStore::LoadAvatar(
+    const std::u16string& name, const std::u16string& address) {
+    auto find_iter = avatarsByName_.find(std::make_pair(name, address));
+    if (find_iter == std::end(avatarsByName_)) {
+        return boost::none;
+    }
+
+    return LoadAvatar(find_iter->second);
+}
+
+void InMemoryAvatarStore::ForEachAvatar(const std::function<void(const AvatarRecord&)>& visitor) {
+    for (auto& entry : avatars_) {
+        visitor(entry.second);
+    }
+}
+
+uint32_t InMemoryAvatarStore::InsertAvatar(const AvatarRecord& avatar) {
+    auto key = std::make_pair(avatar.name, avatar.address);
+    if (avatarsByName_.find(key) != std::end(avatarsByName_)) {
+        throw ChatResultException{ChatResultCode::DBFAIL, "Avatar already stored"};
+    }
+
+    auto avatarId = nextAvatarId_++;
+
+    auto& stored = avatars_[avatarId] = avatar;
+    stored.avatarId = avatarId;
+    avatarsByName_[key] = avatarId;
+
+    return avatarId;
+}
+
+void InMemoryAvatarStore::UpdateAvatar(const AvatarRecord& avatar) {
+    auto find_iter = avatars_.find(avatar.avatarId);
+    if (find_iter == std::end(avatars_)) {
+        return;
+    }
+
+    avatarsByName_.erase(std::make_pair(find_iter->second.name, find_iter->second.address));
+    find_iter->second = avatar;
+    avatarsByName_[std::make_pair(avatar.name, avatar.address)] = avatar.avatarId;
+}
+
+void InMemoryAvatarStore::DeleteAvatar(uint32_t avatarId) {
+    auto find_iter = avatars_.find(avatarId);
+    if (find_iter == std::end(avatars_)) {
+        return;
+    }
+
+    avatarsByName_.erase(std::make_pair(find_iter->second.name, find_iter->second.address));
+    avatars_.erase(find_iter);
+}
+
+std::vector<FriendRecord> InMemoryContactStore::LoadFriends(uint32_t avatarId) {
+    std::vector<FriendRecord> friends;
+
+    auto end = friends_.upper_bound(std::make_pair(avatarId, std::numeric_limits<uint32_t>::max()));
+    for (auto iter = friends_.lower_bound(std::make_pair(avatarId, 0u)); iter != end; ++iter) {
+        friends.push_back(iter->second);
+    }
+
+    return friends;
+}
+
+std::vector<IgnoreRecord> InMemoryContactStore::LoadIgnores(uint32_t avatarId) {
+    std::vector<IgnoreRecord> ignores;
+
+    auto end = ignores_.upper_bound(std::make_pair(avatarId, std::numeric_limits<uint32_t>::max()));
+    for (auto iter = ignores_.lower_bound(std::make_pair(avatarId, 0u)); iter != end; ++iter) {
+        ignores.push_back(iter->second);
+    }
+
+    return ignores;
+}
+
+void InMemoryContactStore::ForEachFriend(const std::function<void(const FriendRecord&)>& visitor) {
+    for (auto& entry : friends_) {
+        visitor(entry.second);
+    }
+}
+
+void InMemoryContactStore::ForEachIgnore(const std::function<void(const IgnoreRecord&)>& visitor) {
+    for (auto& entry : ignores_) {
+        visitor(entry.second);
+    }
+}
+
+void InMemoryContactStore::AddFriend(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) {
+    friends_.emplace(std::make_pair(avatarId, friendAvatarId), FriendRecord{avatarId, friendAvatarId, comment});
+}
+
+void InMemoryContactStore::UpdateFriendComment(
+    uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) {
+    auto find_iter = friends_.find(std::make_pair(avatarId, friendAvatarId));
+    if (find_iter != std::end(friends_)) {
+        find_iter->second.comment = comment;
+    }
+}
+
+void InMemoryContactStore::RemoveFriend(uint32_t avatarId, uint32_t friendAvatarId) {
+    friends_.erase(std::make_pair(avatarId, friendAvatarId));
+}
+
+void InMemoryContactStore::AddIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) {
+    ignores_.emplace(std::make_pair(avatarId, ignoreAvatarId), IgnoreRecord{avatarId, ignoreAvatarId});
+}
+
+void InMemoryContactStore::RemoveIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) {
+    ignores_.erase(std::make_pair(avatarId, ignoreAvatarId));
+}
+
+std::vector<RoomRecord> InMemoryRoomStore::LoadRooms(const std::u16string& baseAddress) {
+    std::vector<RoomRecord> rooms;
+
+    for (auto& entry : rooms_) {
+        if (entry.second.roomAddress.compare(0, baseAddress.length(), baseAddress) == 0) {
+            rooms.push_back(entry.second);
+        }
+    }
+
+    return rooms;
+}
+
+uint32_t InMemoryRoomStore::InsertRoom(const RoomRecord& room) {
+    for (auto& entry : rooms_) {
+        if (entry.second.roomName == room.roomName && entry.second.roomAddress == room.roomAddress) {
+            throw ChatResultException{ChatResultCode::DBFAIL, "Room already stored"};
+        }
+    }
+
+    auto roomId = nextRoomId_++;
+
+    auto& stored = rooms_[roomId] = room;
+    stored.roomId = roomId;
+
+    return roomId;
+}
+
+void InMemoryRoomStore::DeleteRoom(uint32_t roomId) {
+    rooms_.erase(roomId);
+}
+
+std::vector<uint32_t> InMemoryRoomStore::LoadRoomMembers(RoomRole role, uint32_t roomId) {
+    auto find_iter = members_.find(std::make_pair(role, roomId));
+    if (find_iter == std::end(members_)) {
+        return {};
+    }
+
+    return find_iter->second;
+}
+
+void InMemoryRoomStore::AddRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) {
+    auto& members = members_[std::make_pair(role, roomId)];
+    if (std::find(std::begin(members), std::end(members), avatarId) == std::end(members)) {
+        members.push_back(avatarId);
+    }
+}
+
+void InMemoryRoomStore::RemoveRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) {
+    auto find_iter = members_.find(std::make_pair(role, roomId));
+    if (find_iter == std::end(members_)) {
+        return;
+    }
+
+    auto& members = find_iter->second;
+    members.erase(std::remove(std::begin(members), std::end(members), avatarId), std::end(members));
+}
+
+uint32_t InMemoryMailStore::InsertMessage(const PersistentMessage& message) {
+    auto messageId = nextMessageId_++;
+
+    auto& stored = messages_[message.header.avatarId][messageId] = message;
+    stored.header.messageId = messageId;
+
+    return messageId;
+}
+
+std::vector<PersistentHeader> InMemoryMailStore::LoadMessageHeaders(uint32_t avatarId) {
+    std::vector<PersistentHeader> headers;
+
+    auto find_iter = messages_.find(avatarId);
+    if (find_iter == std::end(messages_)) {
+        return headers;
+    }
+
+    for (auto& entry : find_iter->second) {
+        auto& header = entry.second.header;
+        if (header.status == PersistentState::NEW || header.status == PersistentState::UNREAD
+            || header.status == PersistentState::READ) {
+            headers.push_back(header);
+        }
+    }
+
+    return headers;
+}
+
+boost::optional<PersistentMessage> InMemoryMailStore::LoadMessage(uint32_t avatarId, uint32_t messageId) {
+    auto avatar_iter = messages_.find(avatarId);
+    if (avatar_iter == std::end(messages_)) {
+        return boost::none;
+    }
+
+    auto find_iter = avatar_iter->second.find(messageId);
+    if (find_iter == std::end(avatar_iter->second)) {
+        return boost::none;
+    }
+
+    return find_iter->second;
+}
+
+void InMemoryMailStore::UpdateMessageStatus(uint32_t avatarId, uint32_t messageId, PersistentState status) {
+    auto avatar_iter = messages_.find(avatarId);
+    if (avatar_iter == std::end(messages_)) {
+        return;
+    }
+
+    auto find_iter = avatar_iter->second.find(messageId);
+    if (find_iter != std::end(avatar_iter->second)) {
+        find_iter->second.header.status = status;
+    }
+}
+
+void InMemoryMailStore::UpdateMessageStatus(
+    uint32_t avatarId, const std::u16string& category, PersistentState status) {
+    auto avatar_iter = messages_.find(avatarId);
+    if (avatar_iter == std::end(messages_)) {
+        return;
+    }
+
+    for (auto& entry : avatar_iter->second) {
+        if (entry.second.header.category == category) {
+            entry.second.header.status = status;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+
+#pragma once
+
+#include "ChatStorage.hpp"
+
+#include <map>
+#include <unordered_map>
+
+/* Stores that keep everything in process memory.
+ *
+ * Nothing survives a restart, these back test runs and deployments that have
+ * no use for persistence. Ids are assigned sequentially from 1.
+ */
+
+class InMemoryAvatarStore : public AvatarStore {
+public:
+    boost::optional<AvatarRecord> LoadAvatar(uint32_t avatarId) override;
+    boost::optional<AvatarRecord> LoadAvatar(const std::u16string& name, const std::u16string& address) override;
+    void ForEachAvatar(const std::function<void(const AvatarRecord&)>& visitor) override;
+
+    uint32_t InsertAvatar(const AvatarRecord& avatar) override;
+    void UpdateAvatar(const AvatarRecord& avatar) override;
+    void DeleteAvatar(uint32_t avatarId) override;
+
+private:
+    std::map<uint32_t, AvatarRecord> avatars_;
+    std::map<std::pair<std::u16string, std::u16string>, uint32_t> avatarsByName_;
+    uint32_t nextAvatarId_ = 1;
+};
+
+class InMemoryContactStore : public ContactStore {
+public:
+    std::vector<FriendRecord> LoadFriends(uint32_t avatarId) override;
+    std::vector<IgnoreRecord> LoadIgnores(uint32_t avatarId) override;
+
+    void ForEachFriend(const std::function<void(const FriendRecord&)>& visitor) override;
+    void ForEachIgnore(const std::function<void(const IgnoreRecord&)>& visitor) override;
+
+    void AddFriend(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) override;
+    void UpdateFriendComment(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) override;
+    void RemoveFriend(uint32_t avatarId, uint32_t friendAvatarId) override;
+
+    void AddIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) override;
+    void RemoveIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) override;
+
+private:
+    // (avatar id, contact id) -> record, ordered so one avatar's contacts are
+    // a range scan.
+    std::map<std::pair<uint32_t, uint32_t>, FriendRecord> friends_;
+    std::map<std::pair<uint32_t, uint32_t>, IgnoreRecord> ignores_;
+};
+
+class InMemoryRoomStore : public RoomStore {
+public:
+    std::vector<RoomRecord> LoadRooms(const std::u16string& baseAddress) override;
+    uint32_t InsertRoom(const RoomRecord& room) override;
+    void DeleteRoom(uint32_t roomId) override;
+
+    std::vector<uint32_t> LoadRoomMembers(RoomRole role, uint32_t roomId) override;
+    void AddRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) override;
+    void RemoveRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) override;
+
+private:
+    std::map<uint32_t, RoomRecord> rooms_;
+    // (role, room id) -> avatar ids
+    std::map<std::pair<RoomRole, uint32_t>, std::vector<uint32_t>> members_;
+    uint32_t nextRoomId_ = 1;
+};
+
+class InMemoryMailStore : public MailStore {
+public:
+    uint32_t InsertMessage(const PersistentMessage& message) override;
+
+    std::vector<PersistentHeader> LoadMessageHeaders(uint32_t avatarId) override;
+    boost::optional<PersistentMessage> LoadMessage(uint32_t avatarId, uint32_t messageId) override;
+
+    void UpdateMessageStatus(uint32_t avatarId, uint32_t messageId, PersistentState status) override;
+    void UpdateMessageStatus(
+        uint32_t avatarId, const std::u16string& category, PersistentState status) override;
+
+private:
+    // avatar id -> message id -> message
+    std::unordered_map<uint32_t, std::map<uint32_t, PersistentMessage>> messages_;
+    uint32_t nextMessageId_ = 1;
+};
@@ -0,0 +1,157 @@
+#include "PersistenceWorker.hpp"
+
+#include "easylogging++.h"
+
+#include <chrono>
+
+namespace {
+const uint64_t MAX_COMMANDS_PER_TRANSACTION = 1000;
+}
+
+PersistenceWorker::PersistenceWorker(
+    const std::string& databasePath, const SQLite3Settings& settings, uint32_t commitIntervalMs)
+    : commitIntervalMs_{commitIntervalMs} {
+    if (sqlite3_open(databasePath.c_str(), &db_) != SQLITE_OK) {
+        SQLite3Exception error{sqlite3_errcode(db_), sqlite3_errmsg(db_)};
+        sqlite3_close(db_);
+        throw error;
+    }
+
+    try {
+        ApplySQLite3Settings(db_, settings);
+    } catch (const SQLite3Exception&) {
+        sqlite3_close(db_);
+        throw;
+    }
+
+    statements_ = std::make_unique<SQLite3StatementCache>(db_);
+
+    thread_ = std::thread{[this]() { Run(); }};
+}
+
+PersistenceWorker::~PersistenceWorker() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        running_ = false;
+    }
+
+    wakeup_.notify_one();
+    thread_.join();
+
+    ReportFailures();
+
+    statements_.reset();
+    sqlite3_close(db_);
+}
+
+uint64_t PersistenceWorker::Enqueue(const char* operation, Command command) {
+    // Numbering and queueing happen together so the sequence numbers of
+    // concurrent producers follow queue order, which Flush relies on.
+    std::lock_guard<std::mutex> lock{enqueueMutex_};
+
+    auto sequence = ++enqueued_;
+    commands_.Push(QueuedCommand{operation, std::move(command)});
+    return sequence;
+}
+
+void PersistenceWorker::Flush() {
+    Flush(enqueued_.load());
+}
+
+void PersistenceWorker::Flush(uint64_t sequence) {
+    if (completed_.load() >= sequence) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    flushRequested_ = true;
+    wakeup_.notify_one();
+
+    flushed_.wait(lock, [this, sequence]() { return completed_.load() >= sequence; });
+}
+
+void PersistenceWorker::ReportFailures() {
+    std::string failure;
+    while (failures_.TryPop(failure)) {
+        LOG(ERROR) << "Deferred database write failed: " << failure;
+    }
+}
+
+void PersistenceWorker::Run() {
+    while (true) {
+        auto committed = CommitBatch();
+
+        if (committed > 0) {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                completed_ += committed;
+            }
+
+            flushed_.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{mutex_};
+        if (!running_) {
+            break;
+        }
+
+        wakeup_.wait_for(lock, std::chrono::milliseconds(commitIntervalMs_),
+            [this]() { return flushRequested_ || !running_; });
+        flushRequested_ = false;
+    }
+}
+
+uint64_t PersistenceWorker::CommitBatch() {
+    if (commands_.IsEmpty()) {
+        return 0;
+    }
+
+    // Should the transaction fail to open each command still commits on its
+    // own, which is slower but loses nothing.
+    bool inTransaction = sqlite3_exec(db_, "BEGIN", 0, 0, 0) == SQLITE_OK;
+    if (!inTransaction) {
+        ReportFailure(std::string{"BEGIN: "} + sqlite3_errmsg(db_));
+    }
+
+    uint64_t count = 0;
+    QueuedCommand queued;
+    while (count < MAX_COMMANDS_PER_TRANSACTION && commands_.TryPop(queued)) {
+        try {
+            queued.command(*statements_);
+        } catch (const std::exception& e) {
+            ReportFailure(std::string{queued.operation} + ": " + e.what());
+        }
+
+        ++count;
+    }
+
+    if (inTransaction) {
+        Commit(count);
+    }
+
+    return count;
+}
+
+void PersistenceWorker::Commit(uint64_t count) {
+    // A busy COMMIT leaves the transaction open, so it is retried until the
+    // readers holding the database let go rather than rolling the batch back.
+    auto result = sqlite3_exec(db_, "COMMIT", 0, 0, 0);
+    while (result == SQLITE_BUSY && running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(commitIntervalMs_));
+        result = sqlite3_exec(db_, "COMMIT", 0, 0, 0);
+    }
+
+    if (result != SQLITE_OK) {
+        ReportFailure(std::string{"COMMIT of "} + std::to_string(count) + " writes: " + sqlite3_errmsg(db_));
+
+        if (!sqlite3_get_autocommit(db_)) {
+            sqlite3_exec(db_, "ROLLBACK", 0, 0, 0);
+        }
+    }
+}
+
+void PersistenceWorker::ReportFailure(std::string failure) {
+    ++failed_;
+    failures_.Push(std::move(failure));
+}
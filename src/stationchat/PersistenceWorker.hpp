@@ -0,0 +1,139 @@
+
+#pragma once
+
+#include "MpscQueue.hpp"
+#include "SQLite3.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/** Applies database writes on a dedicated thread and connection.
+ *
+ * The in-memory chat state is authoritative, so the services enqueue their
+ * writes here and carry on without waiting for the disk. Queued commands are
+ * grouped into a single transaction each commit interval. Failures are queued
+ * back to the owning thread and reported by ReportFailures.
+ */
+class PersistenceWorker {
+public:
+    using Command = std::function<void(SQLite3StatementCache&)>;
+
+    PersistenceWorker(const std::string& databasePath, const SQLite3Settings& settings, uint32_t commitIntervalMs);
+    ~PersistenceWorker();
+
+    /** Queues a write and returns its sequence number, which increases in
+     * queue order across all producers. The command runs on the worker thread
+     * and must only capture values it owns.
+     */
+    uint64_t Enqueue(const char* operation, Command command);
+
+    /** Blocks until every write queued so far has been committed.
+     */
+    void Flush();
+
+    /** Blocks until the writes up to and including the given sequence number
+     * have been committed.
+     */
+    void Flush(uint64_t sequence);
+
+    /** Logs the failures reported by the worker since the last call.
+     */
+    void ReportFailures();
+
+    uint64_t GetCommittedCount() const { return completed_.load(); }
+    uint64_t GetFailedCount() const { return failed_.load(); }
+
+private:
+    struct QueuedCommand {
+        const char* operation;
+        Command command;
+    };
+
+    void Run();
+    uint64_t CommitBatch();
+    void Commit(uint64_t count);
+    void ReportFailure(std::string failure);
+
+    sqlite3* db_ = nullptr;
+    std::unique_ptr<SQLite3StatementCache> statements_;
+    MpscQueue<QueuedCommand> commands_;
+    MpscQueue<std::string> failures_;
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<bool> running_{true};
+    uint32_t commitIntervalMs_;
+
+    std::mutex enqueueMutex_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::condition_variable flushed_;
+    bool flushRequested_ = false;
+
+    std::thread thread_;
+};
+
+/** Tracks the last write queued for each key, e.g. an avatar id, so a read
+ * on another connection only waits for the writes to the rows it reads
+ * instead of the whole queue.
+ */
+template <typename Key>
+class PendingWrites {
+public:
+    explicit PendingWrites(PersistenceWorker* writer)
+        : writer_{writer} {}
+
+    void Enqueue(const Key& key, const char* operation, PersistenceWorker::Command command) {
+        pending_[key] = writer_->Enqueue(operation, std::move(command));
+
+        if (pending_.size() >= pruneSize_) {
+            Prune();
+        }
+    }
+
+    bool IsPending(const Key& key) const {
+        auto find_iter = pending_.find(key);
+        return find_iter != std::end(pending_) && find_iter->second > writer_->GetCommittedCount();
+    }
+
+    void WaitFor(const Key& key) {
+        auto find_iter = pending_.find(key);
+        if (find_iter != std::end(pending_)) {
+            writer_->Flush(find_iter->second);
+            pending_.erase(find_iter);
+        }
+    }
+
+    void WaitForAll() {
+        writer_->Flush();
+        pending_.clear();
+    }
+
+private:
+    // Drops the keys whose writes have landed, amortized over the inserts
+    // by letting the map double before the next pass.
+    void Prune() {
+        auto committed = writer_->GetCommittedCount();
+        for (auto iter = std::begin(pending_); iter != std::end(pending_);) {
+            iter = iter->second <= committed ? pending_.erase(iter) : std::next(iter);
+        }
+
+        pruneSize_ = pending_.size() * 2;
+        if (pruneSize_ < MIN_PRUNE_SIZE) {
+            pruneSize_ = MIN_PRUNE_SIZE;
+        }
+    }
+
+    static const size_t MIN_PRUNE_SIZE = 1024;
+
+    PersistenceWorker* writer_;
+    std::unordered_map<Key, uint64_t> pending_;
+    size_t pruneSize_ = MIN_PRUNE_SIZE;
+};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "ChatEnums.hpp"
+#include "ChatStorage.hpp"
 #include "PersistentMessage.hpp"
 
 #include <boost/optional.hpp>
@@ -9,11 +10,9 @@
 #include <cstdint>
 #include <vector>
 
-struct sqlite3;
-
 class PersistentMessageService {
 public:
-    explicit PersistentMessageService(sqlite3* db);
+    explicit PersistentMessageService(MailStore* mailStore);
     ~PersistentMessageService();
 
     void StoreMessage(PersistentMessage& message);
@@ -29,5 +28,5 @@ public:
         uint32_t avatarId, const std::u16string& category, PersistentState newStatus);
 
 private:
-    sqlite3* db_;
+    MailStore* mailStore_;
 };
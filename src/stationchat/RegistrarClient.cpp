@@ -11,7 +11,7 @@
 #include "easylogging++.h"
 
 RegistrarClient::RegistrarClient(UdpConnection* connection, RegistrarNode* node)
-    : NodeClient(connection)
+    : NodeClient(connection, node->GetBufferPool())
     , node_{node} {
     connection->SetHandler(this);
 }
@@ -20,7 +20,7 @@ RegistrarClient::~RegistrarClient() {}
 
 RegistrarNode* RegistrarClient::GetNode() { return node_; }
 
-void RegistrarClient::OnIncoming(std::istringstream& istream) {
+void RegistrarClient::OnIncoming(BufferReader& istream) {
     ChatRequestType request_type = ::read<ChatRequestType>(istream);
 
     switch (request_type) {
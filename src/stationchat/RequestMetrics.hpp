@@ -0,0 +1,48 @@
+
+#pragma once
+
+#include "ChatEnums.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+/** Number of gateway request types, the size of request indexed tables. */
+const size_t GATEWAY_REQUEST_TYPE_COUNT = static_cast<size_t>(ChatRequestType::FILTERMESSAGE_EX) + 1;
+
+/** Running totals for one gateway request type.
+ *
+ * Latency is kept as a histogram of power of two buckets: bucket i counts the
+ * requests handled in under 2^i microseconds, the last bucket catches
+ * everything slower.
+ */
+struct RequestMetrics {
+    static const size_t LATENCY_BUCKETS = 20;
+
+    uint64_t calls = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    std::map<ChatResultCode, uint64_t> errors;
+    std::array<uint64_t, LATENCY_BUCKETS> latency{};
+
+    void Record(size_t requestBytes, size_t responseBytes, ChatResultCode result,
+        std::chrono::microseconds elapsed) {
+        ++calls;
+        bytesIn += requestBytes;
+        bytesOut += responseBytes;
+
+        if (result != ChatResultCode::SUCCESS) {
+            ++errors[result];
+        }
+
+        size_t bucket = 0;
+        for (auto micros = elapsed.count(); micros > 0 && bucket < LATENCY_BUCKETS - 1; micros >>= 1) {
+            ++bucket;
+        }
+
+        ++latency[bucket];
+    }
+};
+
+using RequestMetricsTable = std::array<RequestMetrics, GATEWAY_REQUEST_TYPE_COUNT>;
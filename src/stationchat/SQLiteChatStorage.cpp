@@ -0,0 +1,687 @@
+#include "SQLiteChatStorage.hpp"
+
+#include "ChatEnums.hpp"
+#include "PersistenceWorker.hpp"
+#include "StringUtils.hpp"
+
+#include "easylogging++.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+const int BENCHMARK_ROWS = 20000;
+const int BENCHMARK_BATCH_SIZE = 100;
+const int BENCHMARK_AVATARS = 1000;
+
+// Version 0 is the schema created by extras/init_database.sql before
+// migrations were tracked. New steps are appended here and to that file.
+const std::vector<SQLite3Migration> CHAT_MIGRATIONS{
+    {1, "index mailbox, reverse contact and room address lookups",
+        "CREATE INDEX IF NOT EXISTS persistent_message_avatar_id_status ON persistent_message (avatar_id, status);"
+        "CREATE INDEX IF NOT EXISTS friend_friend_avatar_id ON friend (friend_avatar_id);"
+        "CREATE INDEX IF NOT EXISTS ignore_ignore_avatar_id ON ignore (ignore_avatar_id);"
+        "CREATE INDEX IF NOT EXISTS room_room_address ON room (room_address)"},
+};
+
+std::u16string ColumnWideText(const SQLite3Statement& stmt, int column) {
+    auto tmp = stmt.ColumnText(column);
+    return std::u16string{std::begin(tmp), std::end(tmp)};
+}
+
+AvatarRecord ReadAvatar(const SQLite3Statement& stmt) {
+    AvatarRecord avatar;
+
+    avatar.avatarId = stmt.ColumnInt(0);
+    avatar.userId = stmt.ColumnInt(1);
+    avatar.name = ColumnWideText(stmt, 2);
+    avatar.address = ColumnWideText(stmt, 3);
+    avatar.attributes = stmt.ColumnInt(4);
+
+    return avatar;
+}
+
+PersistentHeader ReadHeader(const SQLite3Statement& stmt) {
+    PersistentHeader header;
+
+    header.messageId = stmt.ColumnInt(0);
+    header.avatarId = stmt.ColumnInt(1);
+    header.fromName = ColumnWideText(stmt, 2);
+    header.fromAddress = ColumnWideText(stmt, 3);
+    header.subject = ColumnWideText(stmt, 4);
+    header.sentTime = stmt.ColumnInt(5);
+    header.status = static_cast<PersistentState>(stmt.ColumnInt(6));
+    header.folder = ColumnWideText(stmt, 7);
+    header.category = ColumnWideText(stmt, 8);
+
+    return header;
+}
+
+const char* RoomRoleTable(RoomRole role) {
+    switch (role) {
+    case RoomRole::ADMINISTRATOR: return "room_administrator";
+    case RoomRole::MODERATOR: return "room_moderator";
+    case RoomRole::BANNED: return "room_ban";
+    }
+
+    return "";
+}
+
+const char* RoomRoleColumn(RoomRole role) {
+    switch (role) {
+    case RoomRole::ADMINISTRATOR: return "admin_avatar_id";
+    case RoomRole::MODERATOR: return "moderator_avatar_id";
+    case RoomRole::BANNED: return "banned_avatar_id";
+    }
+
+    return "";
+}
+
+void RemoveDatabaseFiles(const std::string& databasePath) {
+    for (auto suffix : {"", "-journal", "-wal", "-shm"}) {
+        std::remove((databasePath + suffix).c_str());
+    }
+}
+
+// Smallest string greater than every string starting with prefix, under the
+// default BINARY collation. Empty if there is none, i.e. the prefix is empty
+// or all 0xFF bytes.
+std::string PrefixUpperBound(std::string prefix) {
+    while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF) {
+        prefix.pop_back();
+    }
+
+    if (!prefix.empty()) {
+        prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+    }
+
+    return prefix;
+}
+
+double PerSecond(int count, std::chrono::steady_clock::duration elapsed) {
+    auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+    return seconds > 0 ? count / seconds : 0;
+}
+
+} // namespace
+
+int MigrateChatDatabase(sqlite3* db) {
+    return MigrateSQLite3Database(db, CHAT_MIGRATIONS);
+}
+
+void BenchmarkSQLiteStorage(const std::string& databasePath, const SQLite3Settings& settings) {
+    RemoveDatabaseFiles(databasePath);
+
+    sqlite3* db = nullptr;
+    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK) {
+        LOG(ERROR) << "Unable to open benchmark database " << databasePath << ": " << sqlite3_errmsg(db);
+        sqlite3_close(db);
+        return;
+    }
+
+    try {
+        ApplySQLite3Settings(db, settings);
+
+        SQLite3StatementCache statements{db};
+        statements.Prepare("CREATE TABLE message (id INTEGER PRIMARY KEY, avatar_id INTEGER, subject TEXT, "
+                           "body TEXT)")->Execute();
+        statements.Prepare("CREATE INDEX message_avatar_id ON message (avatar_id)")->Execute();
+
+        // Inserts are grouped into transactions the way the persistence worker
+        // commits them.
+        auto start = std::chrono::steady_clock::now();
+        for (int row = 0; row < BENCHMARK_ROWS; ++row) {
+            if (row % BENCHMARK_BATCH_SIZE == 0) {
+                statements.Prepare("BEGIN")->Execute();
+            }
+
+            auto stmt = statements.Prepare(
+                "INSERT INTO message (avatar_id, subject, body) VALUES (@avatar_id, @subject, @body)");
+            stmt->BindInt("@avatar_id", row % BENCHMARK_AVATARS);
+            stmt->BindText("@subject", "Benchmark message subject");
+            stmt->BindText("@body", std::string(256, 'x'));
+            stmt->Execute();
+
+            if (row % BENCHMARK_BATCH_SIZE == BENCHMARK_BATCH_SIZE - 1 || row == BENCHMARK_ROWS - 1) {
+                statements.Prepare("COMMIT")->Execute();
+            }
+        }
+        auto insertElapsed = std::chrono::steady_clock::now() - start;
+
+        int rowsRead = 0;
+        start = std::chrono::steady_clock::now();
+        for (int avatarId = 0; avatarId < BENCHMARK_AVATARS; ++avatarId) {
+            auto stmt = statements.Prepare("SELECT id, subject FROM message WHERE avatar_id = @avatar_id");
+            stmt->BindInt("@avatar_id", avatarId);
+            while (stmt->Step()) {
+                ++rowsRead;
+            }
+        }
+        auto queryElapsed = std::chrono::steady_clock::now() - start;
+
+        LOG(INFO) << "SQLite benchmark: " << static_cast<uint64_t>(PerSecond(BENCHMARK_ROWS, insertElapsed))
+                  << " inserts/s in batches of " << BENCHMARK_BATCH_SIZE << ", "
+                  << static_cast<uint64_t>(PerSecond(BENCHMARK_AVATARS, queryElapsed)) << " queries/s reading "
+                  << rowsRead << " rows";
+    } catch (const SQLite3Exception& e) {
+        LOG(ERROR) << "SQLite benchmark failed: " << e.what();
+    }
+
+    sqlite3_close(db);
+    RemoveDatabaseFiles(databasePath);
+}
+
+SQLiteAvatarStore::SQLiteAvatarStore(sqlite3* db, PersistenceWorker* writer)
+    : db_{db}
+    , statements_{db}
+    , writes_{writer} {}
+
+boost::optional<AvatarRecord> SQLiteAvatarStore::LoadAvatar(uint32_t avatarId) {
+    writes_.WaitFor(avatarId);
+
+    auto stmt = statements_.Prepare(
+        "SELECT id, user_id, name, address, attributes FROM avatar WHERE id = @avatar_id");
+
+    stmt->BindInt("@avatar_id", avatarId);
+
+    if (!stmt->Step()) {
+        return boost::none;
+    }
+
+    return ReadAvatar(*stmt);
+}
+
+boost::optional<AvatarRecord> SQLiteAvatarStore::LoadAvatar(
+    const std::u16string& name, const std::u16string& address) {
+    boost::optional<AvatarRecord> avatar;
+
+    {
+        auto stmt = statements_.Prepare("SELECT id, user_id, name, address, attributes FROM avatar "
+                                        "WHERE name = @name AND address = @address");
+
+        stmt->BindText("@name", FromWideString(name));
+        stmt->BindText("@address", FromWideString(address));
+
+        if (stmt->Step()) {
+            avatar = ReadAvatar(*stmt);
+        }
+    }
+
+    // Names never change once stored, so only writes queued for the avatar
+    // found can leave this row stale.
+    if (avatar && writes_.IsPending(avatar->avatarId)) {
+        return LoadAvatar(avatar->avatarId);
+    }
+
+    return avatar;
+}
+
+void SQLiteAvatarStore::ForEachAvatar(const std::function<void(const AvatarRecord&)>& visitor) {
+    writes_.WaitForAll();
+
+    auto stmt = statements_.Prepare("SELECT id, user_id, name, address, attributes FROM avatar");
+    while (stmt->Step()) {
+        visitor(ReadAvatar(*stmt));
+    }
+}
+
+uint32_t SQLiteAvatarStore::InsertAvatar(const AvatarRecord& avatar) {
+    auto insert = [this, &avatar]() {
+        auto stmt = statements_.Prepare("INSERT INTO avatar (user_id, name, address, attributes) "
+                                        "VALUES (@user_id, @name, @address, @attributes)");
+
+        stmt->BindInt("@user_id", avatar.userId);
+        stmt->BindText("@name", FromWideString(avatar.name));
+        stmt->BindText("@address", FromWideString(avatar.address));
+        stmt->BindInt("@attributes", avatar.attributes);
+
+        stmt->Execute();
+    };
+
+    // Runs on the service connection since the new id is needed immediately.
+    // Only a queued delete of an avatar with the same name can get in its way,
+    // so the queue is drained just when the insert collides.
+    try {
+        try {
+            insert();
+        } catch (const SQLite3Exception& e) {
+            if ((e.code & 0xff) != SQLITE_CONSTRAINT) {
+                throw;
+            }
+
+            writes_.WaitForAll();
+            insert();
+        }
+    } catch (const SQLite3Exception& e) {
+        throw ChatResultException{ChatResultCode::DBFAIL, e.what()};
+    }
+
+    return static_cast<uint32_t>(sqlite3_last_insert_rowid(db_));
+}
+
+void SQLiteAvatarStore::UpdateAvatar(const AvatarRecord& avatar) {
+    auto avatarId = avatar.avatarId;
+    auto userId = avatar.userId;
+    auto attributes = avatar.attributes;
+    auto name = FromWideString(avatar.name);
+    auto address = FromWideString(avatar.address);
+
+    writes_.Enqueue(avatarId, "UpdateAvatar", [avatarId, userId, attributes, name, address](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("UPDATE avatar SET user_id = @user_id, name = @name, "
+                                       "address = @address, attributes = @attributes "
+                                       "WHERE id = @avatar_id");
+
+        stmt->BindInt("@user_id", userId);
+        stmt->BindText("@name", name);
+        stmt->BindText("@address", address);
+        stmt->BindInt("@attributes", attributes);
+        stmt->BindInt("@avatar_id", avatarId);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteAvatarStore::DeleteAvatar(uint32_t avatarId) {
+    writes_.Enqueue(avatarId, "DeleteAvatar", [avatarId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("DELETE FROM avatar WHERE id = @avatar_id");
+
+        stmt->BindInt("@avatar_id", avatarId);
+
+        stmt->Execute();
+    });
+}
+
+SQLiteContactStore::SQLiteContactStore(sqlite3* db, PersistenceWorker* writer)
+    : statements_{db}
+    , writes_{writer} {}
+
+std::vector<FriendRecord> SQLiteContactStore::LoadFriends(uint32_t avatarId) {
+    std::vector<FriendRecord> friends;
+
+    writes_.WaitFor(avatarId);
+
+    auto stmt = statements_.Prepare(
+        "SELECT friend_avatar_id, comment FROM friend WHERE avatar_id = @avatar_id");
+
+    stmt->BindInt("@avatar_id", avatarId);
+
+    while (stmt->Step()) {
+        friends.push_back(FriendRecord{
+            avatarId, static_cast<uint32_t>(stmt->ColumnInt(0)), ToWideString(stmt->ColumnText(1))});
+    }
+
+    return friends;
+}
+
+std::vector<IgnoreRecord> SQLiteContactStore::LoadIgnores(uint32_t avatarId) {
+    std::vector<IgnoreRecord> ignores;
+
+    writes_.WaitFor(avatarId);
+
+    auto stmt = statements_.Prepare(
+        "SELECT ignore_avatar_id FROM ignore WHERE avatar_id = @avatar_id");
+
+    stmt->BindInt("@avatar_id", avatarId);
+
+    while (stmt->Step()) {
+        ignores.push_back(IgnoreRecord{avatarId, static_cast<uint32_t>(stmt->ColumnInt(0))});
+    }
+
+    return ignores;
+}
+
+void SQLiteContactStore::ForEachFriend(const std::function<void(const FriendRecord&)>& visitor) {
+    writes_.WaitForAll();
+
+    auto stmt = statements_.Prepare("SELECT avatar_id, friend_avatar_id, comment FROM friend");
+    while (stmt->Step()) {
+        visitor(FriendRecord{static_cast<uint32_t>(stmt->ColumnInt(0)),
+            static_cast<uint32_t>(stmt->ColumnInt(1)), ToWideString(stmt->ColumnText(2))});
+    }
+}
+
+void SQLiteContactStore::ForEachIgnore(const std::function<void(const IgnoreRecord&)>& visitor) {
+    writes_.WaitForAll();
+
+    auto stmt = statements_.Prepare("SELECT avatar_id, ignore_avatar_id FROM ignore");
+    while (stmt->Step()) {
+        visitor(IgnoreRecord{
+            static_cast<uint32_t>(stmt->ColumnInt(0)), static_cast<uint32_t>(stmt->ColumnInt(1))});
+    }
+}
+
+void SQLiteContactStore::AddFriend(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) {
+    auto commentStr = FromWideString(comment);
+    writes_.Enqueue(avatarId, "AddFriend", [avatarId, friendAvatarId, commentStr](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("INSERT INTO friend (avatar_id, friend_avatar_id, comment) "
+                                       "VALUES (@avatar_id, @friend_avatar_id, @comment)");
+
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@friend_avatar_id", friendAvatarId);
+        stmt->BindText("@comment", commentStr);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteContactStore::UpdateFriendComment(
+    uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) {
+    auto commentStr = FromWideString(comment);
+    writes_.Enqueue(avatarId, "UpdateFriendComment", [avatarId, friendAvatarId, commentStr](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("UPDATE friend SET comment = @comment WHERE avatar_id = "
+                                       "@avatar_id AND friend_avatar_id = @friend_avatar_id");
+
+        stmt->BindText("@comment", commentStr);
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@friend_avatar_id", friendAvatarId);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteContactStore::RemoveFriend(uint32_t avatarId, uint32_t friendAvatarId) {
+    writes_.Enqueue(avatarId, "RemoveFriend", [avatarId, friendAvatarId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("DELETE FROM friend WHERE avatar_id = @avatar_id AND "
+                                       "friend_avatar_id = @friend_avatar_id");
+
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@friend_avatar_id", friendAvatarId);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteContactStore::AddIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) {
+    writes_.Enqueue(avatarId, "AddIgnore", [avatarId, ignoreAvatarId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("INSERT INTO ignore (avatar_id, ignore_avatar_id) VALUES "
+                                       "(@avatar_id, @ignore_avatar_id)");
+
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@ignore_avatar_id", ignoreAvatarId);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteContactStore::RemoveIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) {
+    writes_.Enqueue(avatarId, "RemoveIgnore", [avatarId, ignoreAvatarId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("DELETE FROM ignore WHERE avatar_id = @avatar_id AND "
+                                       "ignore_avatar_id = @ignore_avatar_id");
+
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@ignore_avatar_id", ignoreAvatarId);
+
+        stmt->Execute();
+    });
+}
+
+SQLiteRoomStore::SQLiteRoomStore(sqlite3* db, PersistenceWorker* writer)
+    : db_{db}
+    , statements_{db}
+    , writes_{writer} {}
+
+std::vector<RoomRecord> SQLiteRoomStore::LoadRooms(const std::u16string& baseAddress) {
+    std::vector<RoomRecord> rooms;
+
+    writes_.WaitForAll();
+
+    // A prefix match written as a range so it can use the room_address index,
+    // which LIKE, matching case insensitively, cannot.
+    const std::string columns = "SELECT id, creator_id, creator_name, creator_address, room_name, room_topic, "
+                                "room_password, room_prefix, room_address, room_attributes, room_max_size, "
+                                "room_message_id, created_at, node_level FROM room ";
+
+    auto baseAddressStr = FromWideString(baseAddress);
+    auto upperBound = PrefixUpperBound(baseAddressStr);
+
+    auto stmt = statements_.Prepare(upperBound.empty()
+            ? columns + "WHERE room_address >= @baseAddress"
+            : columns + "WHERE room_address >= @baseAddress AND room_address < @upperBound");
+
+    stmt->BindText("@baseAddress", baseAddressStr);
+    if (!upperBound.empty()) {
+        stmt->BindText("@upperBound", upperBound);
+    }
+
+    while (stmt->Step()) {
+        RoomRecord room;
+
+        room.roomId = stmt->ColumnInt(0);
+        room.creatorId = stmt->ColumnInt(1);
+        room.creatorName = ColumnWideText(*stmt, 2);
+        room.creatorAddress = ColumnWideText(*stmt, 3);
+        room.roomName = ColumnWideText(*stmt, 4);
+        room.roomTopic = ColumnWideText(*stmt, 5);
+        room.roomPassword = ColumnWideText(*stmt, 6);
+        room.roomPrefix = ColumnWideText(*stmt, 7);
+        room.roomAddress = ColumnWideText(*stmt, 8);
+        room.roomAttributes = stmt->ColumnInt(9);
+        room.maxRoomSize = stmt->ColumnInt(10);
+        room.roomMessageId = stmt->ColumnInt(11);
+        room.createTime = stmt->ColumnInt(12);
+        room.nodeLevel = stmt->ColumnInt(13);
+
+        rooms.push_back(std::move(room));
+    }
+
+    return rooms;
+}
+
+uint32_t SQLiteRoomStore::InsertRoom(const RoomRecord& room) {
+    auto insert = [this, &room]() {
+        auto stmt = statements_.Prepare("INSERT INTO room (creator_id, creator_name, creator_address, room_name, "
+                                        "room_topic, room_password, room_prefix, room_address, room_attributes, "
+                                        "room_max_size, room_message_id, created_at, node_level) VALUES (@creator_id, "
+                                        "@creator_name, @creator_address, @room_name, @room_topic, @room_password, "
+                                        "@room_prefix, @room_address, @room_attributes, @room_max_size, @room_message_id, "
+                                        "@created_at, @node_level)");
+
+        stmt->BindInt("@creator_id", room.creatorId);
+        stmt->BindText("@creator_name", FromWideString(room.creatorName));
+        stmt->BindText("@creator_address", FromWideString(room.creatorAddress));
+        stmt->BindText("@room_name", FromWideString(room.roomName));
+        stmt->BindText("@room_topic", FromWideString(room.roomTopic));
+        stmt->BindText("@room_password", FromWideString(room.roomPassword));
+        stmt->BindText("@room_prefix", FromWideString(room.roomPrefix));
+        stmt->BindText("@room_address", FromWideString(room.roomAddress));
+        stmt->BindInt("@room_attributes", room.roomAttributes);
+        stmt->BindInt("@room_max_size", room.maxRoomSize);
+        stmt->BindInt("@room_message_id", room.roomMessageId);
+        stmt->BindInt("@created_at", room.createTime);
+        stmt->BindInt("@node_level", room.nodeLevel);
+
+        stmt->Execute();
+    };
+
+    // The row id is needed immediately, so this insert stays on the service
+    // connection. A queued delete of a room with the same name and address
+    // makes it collide, in which case it is retried once the queue drains.
+    try {
+        try {
+            insert();
+        } catch (const SQLite3Exception& e) {
+            if ((e.code & 0xff) != SQLITE_CONSTRAINT) {
+                throw;
+            }
+
+            writes_.WaitForAll();
+            insert();
+        }
+    } catch (const SQLite3Exception& e) {
+        throw ChatResultException{ChatResultCode::DBFAIL, e.what()};
+    }
+
+    return static_cast<uint32_t>(sqlite3_last_insert_rowid(db_));
+}
+
+void SQLiteRoomStore::DeleteRoom(uint32_t roomId) {
+    writes_.Enqueue(roomId, "DeleteRoom", [roomId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("DELETE FROM room WHERE id = @id");
+
+        stmt->BindInt("@id", roomId);
+
+        stmt->Execute();
+    });
+}
+
+std::vector<uint32_t> SQLiteRoomStore::LoadRoomMembers(RoomRole role, uint32_t roomId) {
+    std::vector<uint32_t> avatarIds;
+
+    writes_.WaitFor(roomId);
+
+    auto stmt = statements_.Prepare(std::string{"SELECT "} + RoomRoleColumn(role) + " FROM " + RoomRoleTable(role)
+        + " WHERE room_id = @room_id");
+
+    stmt->BindInt("@room_id", roomId);
+
+    while (stmt->Step()) {
+        avatarIds.push_back(static_cast<uint32_t>(stmt->ColumnInt(0)));
+    }
+
+    return avatarIds;
+}
+
+void SQLiteRoomStore::AddRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) {
+    auto sql = std::string{"INSERT OR IGNORE INTO "} + RoomRoleTable(role) + " (" + RoomRoleColumn(role)
+        + ", room_id) VALUES (@avatar_id, @room_id)";
+
+    writes_.Enqueue(roomId, "AddRoomMember", [sql, roomId, avatarId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare(sql);
+
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@room_id", roomId);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteRoomStore::RemoveRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) {
+    auto sql = std::string{"DELETE FROM "} + RoomRoleTable(role) + " WHERE " + RoomRoleColumn(role)
+        + " = @avatar_id AND room_id = @room_id";
+
+    writes_.Enqueue(roomId, "RemoveRoomMember", [sql, roomId, avatarId](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare(sql);
+
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindInt("@room_id", roomId);
+
+        stmt->Execute();
+    });
+}
+
+SQLiteMailStore::SQLiteMailStore(sqlite3* db, PersistenceWorker* writer)
+    : statements_{db}
+    , writes_{writer} {
+    // Messages are inserted by the persistence worker, so ids are handed out
+    // here rather than read back from the insert.
+    writes_.WaitForAll();
+
+    auto stmt = statements_.Prepare("SELECT IFNULL(MAX(id), 0) FROM persistent_message");
+    if (stmt->Step()) {
+        nextMessageId_ = static_cast<uint32_t>(stmt->ColumnInt(0)) + 1;
+    }
+}
+
+uint32_t SQLiteMailStore::InsertMessage(const PersistentMessage& message) {
+    auto messageId = nextMessageId_++;
+
+    writes_.Enqueue(message.header.avatarId, "InsertMessage", [messageId, message](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("INSERT INTO persistent_message (id, avatar_id, from_name, from_address, subject, "
+                                       "sent_time, status, "
+                                       "folder, category, message, oob) VALUES (@id, @avatar_id, @from_name, @from_address, "
+                                       "@subject, @sent_time, @status, @folder, @category, @message, @oob)");
+
+        stmt->BindInt("@id", messageId);
+        stmt->BindInt("@avatar_id", message.header.avatarId);
+        stmt->BindText("@from_name", FromWideString(message.header.fromName));
+        stmt->BindText("@from_address", FromWideString(message.header.fromAddress));
+        stmt->BindText("@subject", FromWideString(message.header.subject));
+        stmt->BindInt("@sent_time", message.header.sentTime);
+        stmt->BindInt("@status", static_cast<uint32_t>(message.header.status));
+        stmt->BindText("@folder", FromWideString(message.header.folder));
+        stmt->BindText("@category", FromWideString(message.header.category));
+        stmt->BindText("@message", FromWideString(message.message));
+        stmt->BindBlob("@oob", message.oob.data(), static_cast<int>(message.oob.size() * 2));
+
+        stmt->Execute();
+    });
+
+    return messageId;
+}
+
+std::vector<PersistentHeader> SQLiteMailStore::LoadMessageHeaders(uint32_t avatarId) {
+    std::vector<PersistentHeader> headers;
+
+    writes_.WaitFor(avatarId);
+
+    auto stmt = statements_.Prepare("SELECT id, avatar_id, from_name, from_address, subject, sent_time, status, "
+                                    "folder, category FROM persistent_message WHERE avatar_id = "
+                                    "@avatar_id AND status IN (1, 2, 3)");
+
+    stmt->BindInt("@avatar_id", avatarId);
+
+    while (stmt->Step()) {
+        headers.push_back(ReadHeader(*stmt));
+    }
+
+    return headers;
+}
+
+boost::optional<PersistentMessage> SQLiteMailStore::LoadMessage(uint32_t avatarId, uint32_t messageId) {
+    PersistentMessage message;
+
+    writes_.WaitFor(avatarId);
+
+    auto stmt = statements_.Prepare("SELECT id, avatar_id, from_name, from_address, subject, sent_time, status, "
+                                    "folder, category, message, oob FROM persistent_message WHERE id = @message_id "
+                                    "AND avatar_id = @avatar_id");
+
+    stmt->BindInt("@message_id", messageId);
+    stmt->BindInt("@avatar_id", avatarId);
+
+    if (!stmt->Step()) {
+        return boost::none;
+    }
+
+    message.header = ReadHeader(*stmt);
+    message.message = ColumnWideText(*stmt, 9);
+
+    int size = stmt->ColumnBytes(10);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(stmt->ColumnBlob(10));
+
+    message.oob.resize(size / 2);
+    for (int i = 0; i < size/2; ++i) {
+        message.oob[i] = *reinterpret_cast<const uint16_t*>(data + i*2);
+    }
+
+    return message;
+}
+
+void SQLiteMailStore::UpdateMessageStatus(uint32_t avatarId, uint32_t messageId, PersistentState status) {
+    writes_.Enqueue(avatarId, "UpdateMessageStatus", [avatarId, messageId, status](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("UPDATE persistent_message SET status = @status WHERE id = @message_id AND "
+                                       "avatar_id = @avatar_id");
+
+        stmt->BindInt("@status", static_cast<uint32_t>(status));
+        stmt->BindInt("@message_id", messageId);
+        stmt->BindInt("@avatar_id", avatarId);
+
+        stmt->Execute();
+    });
+}
+
+void SQLiteMailStore::UpdateMessageStatus(
+    uint32_t avatarId, const std::u16string& category, PersistentState status) {
+    auto categoryStr = FromWideString(category);
+    writes_.Enqueue(avatarId, "BulkUpdateMessageStatus", [avatarId, categoryStr, status](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("UPDATE persistent_message SET status = @status WHERE avatar_id = @avatar_id AND "
+                                       "category = @category");
+
+        stmt->BindInt("@status", static_cast<uint32_t>(status));
+        stmt->BindInt("@avatar_id", avatarId);
+        stmt->BindText("@category", categoryStr);
+
+        stmt->Execute();
+    });
+}
@@ -0,0 +1,106 @@
+
+#pragma once
+
+#include "ChatStorage.hpp"
+#include "PersistenceWorker.hpp"
+#include "SQLite3.hpp"
+
+#include <string>
+
+/** Upgrades the chat database schema in place to the current version.
+ *
+ * Returns the number of migrations applied.
+ */
+int MigrateChatDatabase(sqlite3* db);
+
+/** Measures insert and query throughput under the given settings and logs it.
+ *
+ * Runs against a scratch database at databasePath that is deleted afterwards,
+ * the chat database itself is not touched.
+ */
+void BenchmarkSQLiteStorage(const std::string& databasePath, const SQLite3Settings& settings);
+
+/* SQLite backed stores.
+ *
+ * Reads and the inserts whose row id is needed right away run on the shared
+ * service connection. All other writes are handed to the persistence worker,
+ * and a read first waits for the writes still queued for the avatar or room
+ * it reads, while full table scans wait for the whole queue.
+ */
+
+class SQLiteAvatarStore : public AvatarStore {
+public:
+    SQLiteAvatarStore(sqlite3* db, PersistenceWorker* writer);
+
+    boost::optional<AvatarRecord> LoadAvatar(uint32_t avatarId) override;
+    boost::optional<AvatarRecord> LoadAvatar(const std::u16string& name, const std::u16string& address) override;
+    void ForEachAvatar(const std::function<void(const AvatarRecord&)>& visitor) override;
+
+    uint32_t InsertAvatar(const AvatarRecord& avatar) override;
+    void UpdateAvatar(const AvatarRecord& avatar) override;
+    void DeleteAvatar(uint32_t avatarId) override;
+
+private:
+    sqlite3* db_;
+    SQLite3StatementCache statements_;
+    PendingWrites<uint32_t> writes_;
+};
+
+class SQLiteContactStore : public ContactStore {
+public:
+    SQLiteContactStore(sqlite3* db, PersistenceWorker* writer);
+
+    std::vector<FriendRecord> LoadFriends(uint32_t avatarId) override;
+    std::vector<IgnoreRecord> LoadIgnores(uint32_t avatarId) override;
+
+    void ForEachFriend(const std::function<void(const FriendRecord&)>& visitor) override;
+    void ForEachIgnore(const std::function<void(const IgnoreRecord&)>& visitor) override;
+
+    void AddFriend(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) override;
+    void UpdateFriendComment(uint32_t avatarId, uint32_t friendAvatarId, const std::u16string& comment) override;
+    void RemoveFriend(uint32_t avatarId, uint32_t friendAvatarId) override;
+
+    void AddIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) override;
+    void RemoveIgnore(uint32_t avatarId, uint32_t ignoreAvatarId) override;
+
+private:
+    SQLite3StatementCache statements_;
+    PendingWrites<uint32_t> writes_;
+};
+
+class SQLiteRoomStore : public RoomStore {
+public:
+    SQLiteRoomStore(sqlite3* db, PersistenceWorker* writer);
+
+    std::vector<RoomRecord> LoadRooms(const std::u16string& baseAddress) override;
+    uint32_t InsertRoom(const RoomRecord& room) override;
+    void DeleteRoom(uint32_t roomId) override;
+
+    std::vector<uint32_t> LoadRoomMembers(RoomRole role, uint32_t roomId) override;
+    void AddRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) override;
+    void RemoveRoomMember(RoomRole role, uint32_t roomId, uint32_t avatarId) override;
+
+private:
+    sqlite3* db_;
+    SQLite3StatementCache statements_;
+    PendingWrites<uint32_t> writes_;
+};
+
+class SQLiteMailStore : public MailStore {
+public:
+    SQLiteMailStore(sqlite3* db, PersistenceWorker* writer);
+
+    uint32_t InsertMessage(const PersistentMessage& message) override;
+
+    std::vector<PersistentHeader> LoadMessageHeaders(uint32_t avatarId) override;
+    boost::optional<PersistentMessage> LoadMessage(uint32_t avatarId, uint32_t messageId) override;
+
+    void UpdateMessageStatus(uint32_t avatarId, uint32_t messageId, PersistentState status) override;
+    void UpdateMessageStatus(
+        uint32_t avatarId, const std::u16string& category, PersistentState status) override;
+
+private:
+    SQLite3StatementCache statements_;
+    PendingWrites<uint32_t> writes_;
+    uint32_t nextMessageId_ = 1;
+};
@@ -2,6 +2,13 @@
 
 #include "easylogging++.h"
 
+#include <algorithm>
+#include <thread>
+
+namespace {
+const std::chrono::seconds TICK_STATS_INTERVAL{60};
+}
+
 StationChatApp::StationChatApp(StationChatConfig config)
     : config_{std::move(config)} {
     registrarNode_ = std::make_unique<RegistrarNode>(config_);
@@ -9,9 +16,83 @@ StationChatApp::StationChatApp(StationChatConfig config)
 
     gatewayNode_ = std::make_unique<GatewayNode>(config_);
     LOG(INFO) << "Gateway listening @" << config_.gatewayAddress << ":" << config_.gatewayPort;
+
+    nextReport_ = std::chrono::steady_clock::now() + TICK_STATS_INTERVAL;
+
+    if (config_.registrarThread) {
+#ifdef ELPP_THREAD_SAFE
+        registrarRunning_ = true;
+        registrarThread_ = std::thread{[this]() { RunRegistrar(); }};
+        LOG(INFO) << "Registrar running on its own thread";
+#else
+        LOG(WARNING) << "registrar_thread requires a build with ENABLE_REGISTRAR_THREAD, "
+                     << "servicing the registrar on the main loop";
+#endif
+    }
+}
+
+StationChatApp::~StationChatApp() {
+    if (registrarThread_.joinable()) {
+        registrarRunning_ = false;
+        registrarThread_.join();
+    }
 }
 
 void StationChatApp::Tick() {
-    registrarNode_->Tick();
-    gatewayNode_->Tick();
+    bool registrarActive = !registrarThread_.joinable() && registrarNode_->Tick();
+    bool gatewayActive = gatewayNode_->Tick();
+
+    lastTickActive_ = registrarActive || gatewayActive;
+
+    ++stats_.ticks;
+    if (lastTickActive_) {
+        ++stats_.activeTicks;
+    }
+
+    if (std::chrono::steady_clock::now() >= nextReport_) {
+        LogTickStats();
+    }
+}
+
+void StationChatApp::WaitForWork() {
+    if (lastTickActive_) {
+        idleSleepMs_ = 0;
+        ++stats_.trafficWakes;
+        return;
+    }
+
+    idleSleepMs_ = NextIdleSleep(idleSleepMs_);
+    std::this_thread::sleep_for(std::chrono::milliseconds(idleSleepMs_));
+
+    ++stats_.timeoutWakes;
+    stats_.sleptMs += idleSleepMs_;
+}
+
+uint32_t StationChatApp::NextIdleSleep(uint32_t idleSleepMs) const {
+    return std::min(std::max(idleSleepMs * 2, 1u), std::max(config_.maxIdleSleep, 1u));
+}
+
+void StationChatApp::RunRegistrar() {
+    uint32_t idleSleepMs = 0;
+
+    while (registrarRunning_) {
+        if (registrarNode_->Tick()) {
+            idleSleepMs = 0;
+            continue;
+        }
+
+        idleSleepMs = NextIdleSleep(idleSleepMs);
+        std::this_thread::sleep_for(std::chrono::milliseconds(idleSleepMs));
+    }
+}
+
+void StationChatApp::LogTickStats() {
+    LOG(INFO) << "Main loop: " << stats_.ticks - reportedStats_.ticks << " ticks ("
+              << stats_.activeTicks - reportedStats_.activeTicks << " active), "
+              << stats_.trafficWakes - reportedStats_.trafficWakes << " traffic wakes, "
+              << stats_.timeoutWakes - reportedStats_.timeoutWakes << " timeout wakes, "
+              << stats_.sleptMs - reportedStats_.sleptMs << " ms asleep";
+
+    reportedStats_ = stats_;
+    nextReport_ = std::chrono::steady_clock::now() + TICK_STATS_INTERVAL;
 }
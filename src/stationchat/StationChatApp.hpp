@@ -5,21 +5,61 @@
 #include "RegistrarNode.hpp"
 #include "StationChatConfig.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
 
 class StationChatApp {
 public:
     explicit StationChatApp(StationChatConfig config);
+    ~StationChatApp();
+
+    /** Counters describing how the main loop is spending its time.
+    */
+    struct TickStats {
+        uint64_t ticks = 0;
+        // Ticks where packets or connection requests arrived.
+        uint64_t activeTicks = 0;
+        // Ticks run immediately because the previous one saw traffic.
+        uint64_t trafficWakes = 0;
+        // Ticks run after sleeping through an idle backoff.
+        uint64_t timeoutWakes = 0;
+        uint64_t sleptMs = 0;
+    };
 
     bool IsRunning() const { return isRunning_; }
 
     void Tick();
 
+    /** Returns immediately while traffic is flowing. Once the nodes go idle it
+     * sleeps for a backoff that doubles each idle tick, up to max_idle_sleep.
+     */
+    void WaitForWork();
+
+    const TickStats& GetTickStats() const { return stats_; }
+
 private:
+    void LogTickStats();
+    uint32_t NextIdleSleep(uint32_t idleSleepMs) const;
+
+    /** Runs the registrar node on its own thread when registrar_thread is
+     * set. The registrar shares no state with the gateway beyond the
+     * read-only configuration, so the thread is its sole owner.
+     */
+    void RunRegistrar();
+
     StationChatConfig config_;
     bool isRunning_ = true;
+    bool lastTickActive_ = false;
+    uint32_t idleSleepMs_ = 0;
+    TickStats stats_;
+    TickStats reportedStats_;
+    std::chrono::steady_clock::time_point nextReport_;
     std::unique_ptr<GatewayNode> gatewayNode_;
-    std::unique_ptr<RegistrarNode> registrarNode_;    
+    std::unique_ptr<RegistrarNode> registrarNode_;
+    std::atomic<bool> registrarRunning_{false};
+    std::thread registrarThread_;
 };
@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include "SQLite3.hpp"
+
 #include <cstdint>
 #include <string>
 
@@ -22,6 +24,14 @@ struct StationChatConfig {
     std::string registrarAddress;
     uint16_t registrarPort;
     std::string chatDatabasePath;
+    std::string storageBackend = "sqlite";
+    SQLite3Settings sqliteSettings;
+    bool sqliteBenchmark = false;
     std::string loggerConfig;
     bool bindToIp;
+    uint32_t persistenceCommitInterval = 50;
+    bool warmLoadAvatars = false;
+    uint32_t avatarCacheSize = 0;
+    uint32_t maxIdleSleep = 1;
+    bool registrarThread = false;
 };
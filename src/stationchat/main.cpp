@@ -6,10 +6,8 @@
 
 #include <boost/program_options.hpp>
 
-#include <chrono>
 #include <fstream>
 #include <iostream>
-#include <thread>
 
 #ifdef __GNUC__
 #include <execinfo.h>
@@ -37,7 +35,7 @@ int main(int argc, const char* argv[]) {
 
     while (app.IsRunning()) {
         app.Tick();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        app.WaitForWork();
     }
 
     return 0;
@@ -73,6 +71,32 @@ StationChatConfig BuildConfiguration(int argc, const char* argv[]) {
             "when set to true, binds to the config address; otherwise, binds on any interface")
         ("database_path", po::value<std::string>(&config.chatDatabasePath)->default_value("var/stationapi/stationchat.db"),
             "path to the sqlite3 database file")
+        ("storage_backend", po::value<std::string>(&config.storageBackend)->default_value("sqlite"),
+            "where chat data is stored: sqlite, or memory to keep nothing across restarts")
+        ("sqlite_journal_mode", po::value<std::string>(&config.sqliteSettings.journalMode)->default_value("delete"),
+            "sqlite journal mode: delete, truncate, persist, memory, wal or off")
+        ("sqlite_synchronous", po::value<std::string>(&config.sqliteSettings.synchronous)->default_value("full"),
+            "sqlite synchronous level: off, normal, full or extra")
+        ("sqlite_cache_size", po::value<int64_t>(&config.sqliteSettings.cacheSize)->default_value(-16384),
+            "sqlite page cache size in pages, or in KiB when negative")
+        ("sqlite_mmap_size", po::value<int64_t>(&config.sqliteSettings.mmapSize)->default_value(0),
+            "bytes of the database file sqlite may memory map, 0 disables mmap")
+        ("sqlite_busy_timeout", po::value<int>(&config.sqliteSettings.busyTimeout)->default_value(5000),
+            "milliseconds sqlite waits on a locked database before failing")
+        ("sqlite_temp_store", po::value<std::string>(&config.sqliteSettings.tempStore)->default_value("default"),
+            "where sqlite keeps temporary tables: default, file or memory")
+        ("sqlite_benchmark", po::value<bool>(&config.sqliteBenchmark)->default_value(false),
+            "when set to true, measures sqlite insert and query throughput at startup")
+        ("persistence_commit_interval", po::value<uint32_t>(&config.persistenceCommitInterval)->default_value(50),
+            "milliseconds between group commits of deferred database writes")
+        ("warm_load_avatars", po::value<bool>(&config.warmLoadAvatars)->default_value(false),
+            "when set to true, loads all avatars and their contacts at startup")
+        ("avatar_cache_size", po::value<uint32_t>(&config.avatarCacheSize)->default_value(0),
+            "maximum number of avatars kept in memory, 0 for no limit")
+        ("max_idle_sleep", po::value<uint32_t>(&config.maxIdleSleep)->default_value(1),
+            "longest the main loop sleeps in milliseconds once idle")
+        ("registrar_thread", po::value<bool>(&config.registrarThread)->default_value(false),
+            "when set to true, services the registrar on its own thread")
         ;
 
     po::options_description cmdline_options;
@@ -5,6 +5,8 @@
 #include "ChatEnums.hpp"
 
 #include <string>
+#include <utility>
+#include <vector>
 
 class ChatAvatarService;
 class ChatRoomService;
@@ -36,7 +38,8 @@ struct ResFriendStatus {
     const ChatResponseType type = ChatResponseType::FRIENDSTATUS;
     uint32_t track;
     ChatResultCode result;
-    const ChatAvatar* srcAvatar;
+    // Friend list entries resolved to their avatars by the handler.
+    std::vector<std::pair<const ChatAvatar*, std::u16string>> friends;
 };
 
 template <typename StreamT>
@@ -45,12 +48,13 @@ void write(StreamT& ar, const ResFriendStatus& data) {
     write(ar, data.track);
     write(ar, data.result);
 
-    if (data.result == ChatResultCode::SUCCESS && data.srcAvatar) {
-        const auto& friends = data.srcAvatar->GetFriendList();
-
-        write(ar, static_cast<uint32_t>(friends.size()));
-        for (auto& friendContact : friends) {
-            write(ar, friendContact);
+    if (data.result == ChatResultCode::SUCCESS) {
+        write(ar, static_cast<uint32_t>(data.friends.size()));
+        for (auto& friendContact : data.friends) {
+            write(ar, friendContact.first->GetName());
+            write(ar, friendContact.first->GetAddress());
+            write(ar, friendContact.second);
+            write(ar, static_cast<short>(friendContact.first->IsOnline() ? 1 : 0));
         }
     } else {
         write(ar, static_cast<uint32_t>(0));
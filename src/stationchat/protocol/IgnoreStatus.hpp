@@ -4,6 +4,8 @@
 #include "ChatAvatar.hpp"
 #include "ChatEnums.hpp"
 
+#include <vector>
+
 class ChatAvatarService;
 class ChatRoomService;
 class GatewayClient;
@@ -34,7 +36,8 @@ struct ResIgnoreStatus {
     const ChatResponseType type = ChatResponseType::IGNORESTATUS;
     uint32_t track;
     ChatResultCode result;
-    const ChatAvatar* srcAvatar;
+    // Ignore list entries resolved to their avatars by the handler.
+    std::vector<const ChatAvatar*> ignored;
 };
 
 template <typename StreamT>
@@ -43,12 +46,11 @@ void write(StreamT& ar, const ResIgnoreStatus& data) {
     write(ar, data.track);
     write(ar, data.result);
 
-    if (data.result == ChatResultCode::SUCCESS && data.srcAvatar) {
-        const auto& ignored = data.srcAvatar->GetIgnoreList();
-
-        write(ar, static_cast<uint32_t>(ignored.size()));
-        for (auto& ignoredContact : ignored) {
-            write(ar, ignoredContact);
+    if (data.result == ChatResultCode::SUCCESS) {
+        write(ar, static_cast<uint32_t>(data.ignored.size()));
+        for (auto ignoredAvatar : data.ignored) {
+            write(ar, ignoredAvatar->GetName());
+            write(ar, ignoredAvatar->GetAddress());
         }
     } else {
         write(ar, static_cast<uint32_t>(0));
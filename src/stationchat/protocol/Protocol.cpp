@@ -279,7 +279,7 @@ FailoverReLoginAvatar::FailoverReLoginAvatar(
     avatarService_->LoginAvatar(avatar);
 
     if (avatar->GetName().compare(u"SYSTEM") == 0) {
-        client->GetNode()->RegisterClientAddress(avatar->GetAddress(), client);
+        client->GetNode()->RegisterClientAddress(avatar->GetAddressAtom(), client);
         roomService_->LoadRoomsFromStorage(request.address);
     } else {
         client->SendFriendLoginUpdates(avatar);
@@ -301,7 +301,12 @@ FriendStatus::FriendStatus(
         throw ChatResultException{ChatResultCode::SRCAVATARDOESNTEXIST, std::to_string(request.srcAvatarId).c_str()};
     }
 
-    response.srcAvatar = srcAvatar;
+    for (auto& contact : srcAvatar->GetFriendList()) {
+        auto frnd = avatarService_->GetAvatar(contact.frndId);
+        if (frnd) {
+            response.friends.emplace_back(frnd, contact.comment);
+        }
+    }
 }
 
 GetAnyAvatar::GetAnyAvatar(
@@ -372,7 +377,12 @@ IgnoreStatus::IgnoreStatus(
         throw ChatResultException{ChatResultCode::SRCAVATARDOESNTEXIST, std::to_string(request.srcAvatarId).c_str()};
     }
 
-    response.srcAvatar = srcAvatar;
+    for (auto& contact : srcAvatar->GetIgnoreList()) {
+        auto ignoredAvatar = avatarService_->GetAvatar(contact.ignoredId);
+        if (ignoredAvatar) {
+            response.ignored.push_back(ignoredAvatar);
+        }
+    }
 }
 
 KickAvatar::KickAvatar(GatewayClient* client, const RequestType& request, ResponseType& response)
@@ -447,7 +457,7 @@ LoginAvatar::LoginAvatar(GatewayClient* client, const RequestType& request, Resp
     avatarService_->LoginAvatar(avatar);
 
     if (avatar->GetName().compare(u"SYSTEM") == 0) {
-        client->GetNode()->RegisterClientAddress(avatar->GetAddress(), client);
+        client->GetNode()->RegisterClientAddress(avatar->GetAddressAtom(), client);
         roomService_->LoadRoomsFromStorage(request.address);
     } else {
         client->SendFriendLoginUpdates(avatar);
@@ -0,0 +1,35 @@
+#include "catch.hpp"
+
+#include "AddressTable.hpp"
+
+SCENARIO("addresses are interned as stable atoms", "[address]") {
+    GIVEN("an empty address table") {
+        AddressTable table;
+
+        THEN("unknown addresses have no atom") {
+            REQUIRE(table.Find(u"SWG+galaxy+zone") == NULL_ADDRESS_ATOM);
+            REQUIRE(table.GetAddress(NULL_ADDRESS_ATOM).empty());
+        }
+
+        WHEN("two addresses are interned") {
+            auto first = table.Intern(u"SWG+galaxy+zone1");
+            auto second = table.Intern(u"SWG+galaxy+zone2");
+
+            THEN("each gets its own atom that maps back to the address") {
+                REQUIRE(first != NULL_ADDRESS_ATOM);
+                REQUIRE(first != second);
+                REQUIRE(table.GetAddress(first) == u"SWG+galaxy+zone1");
+                REQUIRE(table.GetAddress(second) == u"SWG+galaxy+zone2");
+                REQUIRE(table.GetAtomLimit() == 3);
+            }
+
+            AND_WHEN("an address is interned again") {
+                THEN("the original atom is returned") {
+                    REQUIRE(table.Intern(u"SWG+galaxy+zone1") == first);
+                    REQUIRE(table.Find(u"SWG+galaxy+zone2") == second);
+                    REQUIRE(table.GetAtomLimit() == 3);
+                }
+            }
+        }
+    }
+}
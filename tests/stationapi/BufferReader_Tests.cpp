@@ -0,0 +1,64 @@
+
+#include "catch.hpp"
+
+#include "BufferReader.hpp"
+#include "Serialization.hpp"
+
+#include <sstream>
+
+SCENARIO("reading serialized values from a buffer", "[serialization]") {
+    GIVEN("a buffer containing a serialized integer and wide string") {
+        std::stringstream bs(std::ios_base::out | std::ios_base::in | std::ios_base::binary);
+        write(bs, int32_t{-8});
+        write(bs, std::u16string{u"Some string value"});
+
+        auto str = bs.str();
+        BufferReader reader{reinterpret_cast<const unsigned char*>(str.data()), str.length()};
+
+        WHEN("the values are read from the buffer") {
+            auto testInt = read<int32_t>(reader);
+            auto testStr = read<std::u16string>(reader);
+
+            THEN("the values read are the values expected") {
+                REQUIRE(testInt == -8);
+                REQUIRE(testStr.compare(u"Some string value") == 0);
+            }
+
+            AND_THEN("the entire buffer has been consumed") {
+                REQUIRE(reader.remaining() == 0);
+                REQUIRE(reader.tellg() == str.length());
+            }
+        }
+
+        AND_WHEN("a value is peeked from the buffer") {
+            auto length = peekAt<uint32_t>(reader, 4);
+
+            THEN("the value is read without moving the read position") {
+                REQUIRE(length == 17);
+                REQUIRE(reader.tellg() == 0);
+            }
+        }
+    }
+
+    GIVEN("a buffer too short for the value being read") {
+        const unsigned char data[] = {0x01, 0x02};
+        BufferReader reader{data, sizeof(data)};
+
+        WHEN("an integer wider than the buffer is read") {
+            THEN("an out of range exception is thrown") {
+                REQUIRE_THROWS_AS(read<uint32_t>(reader), const std::out_of_range&);
+            }
+        }
+    }
+
+    GIVEN("a buffer with a string length prefix larger than its contents") {
+        const unsigned char data[] = {0xFF, 0xFF, 0xFF, 0x7F, 0x41, 0x00};
+        BufferReader reader{data, sizeof(data)};
+
+        WHEN("the string is read") {
+            THEN("an out of range exception is thrown before allocating") {
+                REQUIRE_THROWS_AS(read<std::u16string>(reader), const std::out_of_range&);
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+
+#include "catch.hpp"
+
+#include "BufferPool.hpp"
+#include "BufferReader.hpp"
+#include "BufferWriter.hpp"
+#include "Serialization.hpp"
+
+SCENARIO("writing serialized values to a buffer", "[serialization]") {
+    GIVEN("an empty buffer writer") {
+        BufferWriter writer;
+
+        WHEN("an integer and a wide string are written to it") {
+            write(writer, int32_t{-8});
+            write(writer, std::u16string{u"Some string value"});
+
+            THEN("the output contains the integer, a length prefix and two bytes per character") {
+                REQUIRE(writer.length() == 4 + 4 + 17 * 2);
+                REQUIRE(writer.data()[0] == 0xF8);
+                REQUIRE(writer.data()[8] == 'S');
+                REQUIRE(writer.data()[9] == 0);
+            }
+
+            AND_THEN("the values can be read back from the written bytes") {
+                BufferReader reader{writer.data(), writer.length()};
+                REQUIRE(read<int32_t>(reader) == -8);
+                REQUIRE(read<std::u16string>(reader).compare(u"Some string value") == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("output buffers are reused through a pool", "[serialization]") {
+    GIVEN("a buffer pool") {
+        BufferPool pool{16, 64};
+
+        WHEN("a leased buffer is written to and released") {
+            const BufferWriter* leased = nullptr;
+            {
+                auto buffer = pool.Acquire();
+                write(*buffer, uint32_t{42});
+                leased = &*buffer;
+            }
+
+            THEN("the buffer is returned to the pool cleared") {
+                REQUIRE(pool.GetFreeCount() == 1);
+
+                auto buffer = pool.Acquire();
+                REQUIRE(&*buffer == leased);
+                REQUIRE(buffer->length() == 0);
+                REQUIRE(pool.GetFreeCount() == 0);
+            }
+        }
+
+        AND_WHEN("a leased buffer grows beyond the retained capacity") {
+            {
+                auto buffer = pool.Acquire();
+                write(*buffer, std::u16string(256, u'x'));
+            }
+
+            THEN("its memory is trimmed when it is returned") {
+                auto buffer = pool.Acquire();
+                REQUIRE(buffer->capacity() <= 64);
+            }
+        }
+    }
+}
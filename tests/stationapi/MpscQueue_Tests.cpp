@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include "MpscQueue.hpp"
+
+#include <thread>
+#include <vector>
+
+SCENARIO("values pushed to an mpsc queue are popped in order", "[mpsc]") {
+    GIVEN("an empty queue") {
+        MpscQueue<int> queue;
+
+        THEN("nothing can be popped") {
+            int value;
+            REQUIRE(queue.IsEmpty());
+            REQUIRE_FALSE(queue.TryPop(value));
+        }
+
+        WHEN("several values are pushed") {
+            queue.Push(1);
+            queue.Push(2);
+            queue.Push(3);
+
+            THEN("they are popped in the order they were pushed") {
+                int value;
+                REQUIRE(queue.TryPop(value));
+                REQUIRE(value == 1);
+                REQUIRE(queue.TryPop(value));
+                REQUIRE(value == 2);
+                REQUIRE(queue.TryPop(value));
+                REQUIRE(value == 3);
+                REQUIRE_FALSE(queue.TryPop(value));
+            }
+        }
+    }
+}
+
+SCENARIO("an mpsc queue accepts values from several threads", "[mpsc]") {
+    GIVEN("a queue and four producer threads") {
+        MpscQueue<int> queue;
+        const int perThread = 10000;
+
+        WHEN("every producer pushes its values") {
+            std::vector<std::thread> producers;
+            for (int i = 0; i < 4; ++i) {
+                producers.emplace_back([&queue, i, perThread]() {
+                    for (int j = 0; j < perThread; ++j) {
+                        queue.Push(i * perThread + j);
+                    }
+                });
+            }
+
+            for (auto& producer : producers) {
+                producer.join();
+            }
+
+            THEN("every value is popped exactly once") {
+                std::vector<bool> seen(4 * perThread, false);
+                int value, count = 0;
+                bool duplicate = false;
+                while (queue.TryPop(value)) {
+                    duplicate = duplicate || seen[value];
+                    seen[value] = true;
+                    ++count;
+                }
+
+                REQUIRE_FALSE(duplicate);
+                REQUIRE(count == 4 * perThread);
+            }
+        }
+    }
+}
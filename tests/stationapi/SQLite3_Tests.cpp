@@ -0,0 +1,169 @@
+#include "catch.hpp"
+
+#include "SQLite3.hpp"
+
+#include <vector>
+
+SCENARIO("statements are prepared once per connection", "[sqlite]") {
+    GIVEN("an in-memory database and a statement cache") {
+        sqlite3* db;
+        REQUIRE(sqlite3_open(":memory:", &db) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(db, "CREATE TABLE avatar (id INTEGER PRIMARY KEY, name TEXT)", 0, 0, 0) == SQLITE_OK);
+
+        {
+            SQLite3StatementCache statements{db};
+            std::string sql = "INSERT INTO avatar (name) VALUES (@name)";
+
+            WHEN("the same statement is executed several times") {
+                for (auto name : {"first", "second", "third"}) {
+                    auto stmt = statements.Prepare(sql);
+                    stmt->BindText("@name", std::string{name});
+                    stmt->Execute();
+                }
+
+                THEN("it is compiled only once") {
+                    REQUIRE(statements.GetPreparedCount() == 1);
+                }
+
+                AND_THEN("every execution stored its own row") {
+                    auto stmt = statements.Prepare("SELECT name FROM avatar WHERE id = @id");
+                    stmt->BindInt("@id", 3);
+                    REQUIRE(stmt->Step());
+                    REQUIRE(stmt->ColumnText(0) == "third");
+                    REQUIRE_FALSE(stmt->Step());
+                }
+            }
+
+            WHEN("a statement binds a parameter it does not declare") {
+                THEN("an exception is thrown and the statement is left reusable") {
+                    REQUIRE_THROWS_AS(statements.Prepare(sql)->BindText("@missing", "x"), const SQLite3Exception&);
+
+                    auto stmt = statements.Prepare(sql);
+                    stmt->BindText("@name", "fourth");
+                    stmt->Execute();
+                    REQUIRE(sqlite3_changes(db) == 1);
+                }
+            }
+
+            WHEN("a statement is prepared again while it is still leased") {
+                for (auto name : {"first", "second"}) {
+                    auto stmt = statements.Prepare(sql);
+                    stmt->BindText("@name", std::string{name});
+                    stmt->Execute();
+                }
+
+                std::string select = "SELECT id FROM avatar ORDER BY id";
+                std::vector<std::pair<int, int>> pairs;
+
+                auto outer = statements.Prepare(select);
+                while (outer->Step()) {
+                    auto inner = statements.Prepare(select);
+                    while (inner->Step()) {
+                        pairs.emplace_back(outer->ColumnInt(0), inner->ColumnInt(0));
+                    }
+                }
+
+                THEN("each lease steps through its own results") {
+                    REQUIRE(pairs == (std::vector<std::pair<int, int>>{{1, 1}, {1, 2}, {2, 1}, {2, 2}}));
+                }
+
+                AND_THEN("only the first lease used the cached statement") {
+                    REQUIRE(statements.GetPreparedCount() == 2);
+                }
+            }
+
+            WHEN("the sql text is invalid") {
+                THEN("preparing it throws") {
+                    REQUIRE_THROWS_AS(statements.Prepare("SELECT FROM"), const SQLite3Exception&);
+                    REQUIRE(statements.GetPreparedCount() == 0);
+                }
+            }
+        }
+
+        sqlite3_close(db);
+    }
+}
+
+SCENARIO("connection settings are applied through pragmas", "[sqlite]") {
+    GIVEN("an in-memory database") {
+        sqlite3* db;
+        REQUIRE(sqlite3_open(":memory:", &db) == SQLITE_OK);
+
+        WHEN("settings are applied") {
+            SQLite3Settings settings;
+            settings.synchronous = "OFF";
+            settings.cacheSize = -2000;
+            settings.busyTimeout = 1234;
+            settings.tempStore = "memory";
+
+            ApplySQLite3Settings(db, settings);
+
+            THEN("they are in effect on the connection") {
+                auto description = DescribeSQLite3Settings(db);
+                REQUIRE(description.find("synchronous=off") != std::string::npos);
+                REQUIRE(description.find("cache_size=-2000") != std::string::npos);
+                REQUIRE(description.find("busy_timeout=1234") != std::string::npos);
+                REQUIRE(description.find("temp_store=memory") != std::string::npos);
+            }
+        }
+
+        WHEN("a setting has an unknown value") {
+            SQLite3Settings settings;
+            settings.journalMode = "wal; DROP TABLE avatar";
+
+            THEN("applying it throws") {
+                REQUIRE_THROWS_AS(ApplySQLite3Settings(db, settings), const SQLite3Exception&);
+            }
+        }
+
+        sqlite3_close(db);
+    }
+}
+
+SCENARIO("schema migrations are applied once in version order", "[sqlite]") {
+    GIVEN("an in-memory database at version 0") {
+        sqlite3* db;
+        REQUIRE(sqlite3_open(":memory:", &db) == SQLITE_OK);
+
+        std::vector<SQLite3Migration> migrations{
+            {2, "index names", "CREATE INDEX avatar_name ON avatar (name)"},
+            {1, "create avatars", "CREATE TABLE avatar (id INTEGER PRIMARY KEY, name TEXT)"},
+        };
+
+        WHEN("the migrations are run") {
+            auto applied = MigrateSQLite3Database(db, migrations);
+
+            THEN("each is applied and the version advances to the newest") {
+                REQUIRE(applied == 2);
+                REQUIRE(GetSQLite3UserVersion(db) == 2);
+            }
+
+            AND_WHEN("they are run again") {
+                THEN("nothing is applied") {
+                    REQUIRE(MigrateSQLite3Database(db, migrations) == 0);
+                    REQUIRE(GetSQLite3UserVersion(db) == 2);
+                }
+            }
+
+            AND_WHEN("a later migration fails") {
+                migrations.push_back({3, "broken", "CREATE TABLE room (id INTEGER); CREATE INDEX bad ON missing (x)"});
+
+                THEN("it is rolled back and the version is unchanged") {
+                    REQUIRE_THROWS_AS(MigrateSQLite3Database(db, migrations), const SQLite3Exception&);
+                    REQUIRE(GetSQLite3UserVersion(db) == 2);
+                    REQUIRE(sqlite3_exec(db, "SELECT * FROM room", 0, 0, 0) != SQLITE_OK);
+                }
+            }
+        }
+
+        WHEN("the database is newer than the migrations") {
+            REQUIRE(sqlite3_exec(db, "PRAGMA user_version = 5", 0, 0, 0) == SQLITE_OK);
+
+            THEN("migrating throws") {
+                REQUIRE_THROWS_AS(MigrateSQLite3Database(db, migrations), const SQLite3Exception&);
+            }
+        }
+
+        sqlite3_close(db);
+    }
+}
@@ -0,0 +1,37 @@
+#include "catch.hpp"
+
+#include "SlabAllocator.hpp"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+SCENARIO("slab allocator reuses freed blocks", "[slab]") {
+    GIVEN("an allocator with small slabs") {
+        SlabAllocator<uint64_t, 4> allocator;
+
+        WHEN("more blocks are allocated than fit in one slab") {
+            std::vector<void*> blocks;
+            for (int i = 0; i < 6; ++i) {
+                blocks.push_back(allocator.Allocate());
+            }
+
+            THEN("a second slab is added and every block is distinct") {
+                REQUIRE(allocator.GetSlabCount() == 2);
+                REQUIRE(allocator.GetAllocatedCount() == 6);
+                REQUIRE(std::set<void*>(std::begin(blocks), std::end(blocks)).size() == 6);
+            }
+
+            AND_WHEN("a block is freed and another allocated") {
+                allocator.Deallocate(blocks[2]);
+                auto reused = allocator.Allocate();
+
+                THEN("the freed block is handed out again without a new slab") {
+                    REQUIRE(reused == blocks[2]);
+                    REQUIRE(allocator.GetSlabCount() == 2);
+                    REQUIRE(allocator.GetAllocatedCount() == 6);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#include "catch.hpp"
+
+#include "ChatAvatarService.hpp"
+#include "InMemoryChatStorage.hpp"
+#include "StringUtils.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> FriendIds(const ChatAvatar* avatar) {
+    std::vector<uint32_t> ids;
+    for (auto& contact : avatar->GetFriendList()) {
+        ids.push_back(contact.frndId);
+    }
+
+    return ids;
+}
+
+std::vector<uint32_t> IgnoreIds(const ChatAvatar* avatar) {
+    std::vector<uint32_t> ids;
+    for (auto& contact : avatar->GetIgnoreList()) {
+        ids.push_back(contact.ignoredId);
+    }
+
+    return ids;
+}
+
+} // namespace
+
+SCENARIO("warm and lazy loading build the same contact lists", "[avatar]") {
+    GIVEN("stored contacts, some naming avatars that are no longer stored") {
+        AddressTable addressTable;
+        InMemoryAvatarStore avatarStore;
+        InMemoryContactStore contactStore;
+
+        AvatarRecord record;
+        record.address = u"SWG+test";
+        record.name = u"first";
+        auto firstId = avatarStore.InsertAvatar(record);
+        record.name = u"second";
+        auto secondId = avatarStore.InsertAvatar(record);
+
+        auto missingId = secondId + 100;
+        contactStore.AddFriend(firstId, secondId, u"");
+        contactStore.AddFriend(firstId, missingId, u"");
+        contactStore.AddIgnore(firstId, missingId);
+
+        ChatAvatarService lazyService{&addressTable, &avatarStore, &contactStore};
+        auto lazyAvatar = lazyService.GetAvatar(firstId);
+        REQUIRE(lazyAvatar != nullptr);
+
+        WHEN("the avatars are warm loaded instead") {
+            ChatAvatarService warmService{&addressTable, &avatarStore, &contactStore};
+            warmService.WarmLoadAvatars();
+
+            auto warmAvatar = warmService.GetAvatar(firstId);
+            REQUIRE(warmAvatar != nullptr);
+
+            THEN("both keep every stored contact, including the dangling ones") {
+                REQUIRE(FriendIds(lazyAvatar) == (std::vector<uint32_t>{secondId, missingId}));
+                REQUIRE(FriendIds(warmAvatar) == FriendIds(lazyAvatar));
+                REQUIRE(IgnoreIds(lazyAvatar) == std::vector<uint32_t>{missingId});
+                REQUIRE(IgnoreIds(warmAvatar) == IgnoreIds(lazyAvatar));
+            }
+        }
+    }
+}
+
+SCENARIO("resident avatars stay compact", "[avatar][memory]") {
+    GIVEN("ten thousand stored avatars across three addresses, every tenth with a friend") {
+        const uint32_t avatarCount = 10000;
+
+        AddressTable addressTable;
+        InMemoryAvatarStore avatarStore;
+        InMemoryContactStore contactStore;
+
+        for (uint32_t i = 0; i < avatarCount; ++i) {
+            AvatarRecord record;
+            record.name = ToWideString("avatar" + std::to_string(i));
+            record.address = ToWideString("SWG+galaxy" + std::to_string(i % 3));
+            auto avatarId = avatarStore.InsertAvatar(record);
+
+            if (i % 10 == 0 && avatarId > 1) {
+                contactStore.AddFriend(avatarId, avatarId - 1, u"");
+            }
+        }
+
+        WHEN("they are all loaded") {
+            ChatAvatarService avatarService{&addressTable, &avatarStore, &contactStore};
+            avatarService.WarmLoadAvatars();
+
+            auto bytesPerAvatar = avatarService.EstimateCacheMemory() / avatarService.GetCachedAvatarCount();
+            WARN("ChatAvatar is " << sizeof(ChatAvatar) << " bytes, the cache holds about "
+                 << bytesPerAvatar << " bytes per avatar");
+
+            THEN("an avatar is its name plus six words and the cache stays within budget") {
+                REQUIRE(avatarService.GetCachedAvatarCount() == avatarCount);
+                REQUIRE(sizeof(ChatAvatar) <= sizeof(std::u16string) + 6 * sizeof(void*));
+                REQUIRE(bytesPerAvatar <= 256);
+            }
+        }
+    }
+}
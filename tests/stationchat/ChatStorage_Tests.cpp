@@ -0,0 +1,338 @@
+#include "catch.hpp"
+
+#include "ChatEnums.hpp"
+#include "InMemoryChatStorage.hpp"
+#include "PersistenceWorker.hpp"
+#include "SQLiteChatStorage.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* The same cases run against every store implementation, so the services see
+ * the same behavior whichever backend is configured.
+ */
+
+namespace {
+
+const std::string DATABASE_PATH = "chat_storage_tests.db";
+
+struct InMemoryStores {
+    InMemoryAvatarStore avatars;
+    InMemoryContactStore contacts;
+    InMemoryRoomStore rooms;
+    InMemoryMailStore mail;
+};
+
+struct SQLiteStores {
+    SQLiteStores() {
+        std::remove(DATABASE_PATH.c_str());
+        REQUIRE(sqlite3_open(DATABASE_PATH.c_str(), &db) == SQLITE_OK);
+
+        std::ifstream schemaFile{CHAT_SCHEMA_PATH};
+        std::stringstream schema;
+        schema << schemaFile.rdbuf();
+        REQUIRE(sqlite3_exec(db, schema.str().c_str(), 0, 0, 0) == SQLITE_OK);
+
+        ApplySQLite3Settings(db, SQLite3Settings{});
+        MigrateChatDatabase(db);
+
+        // A long commit interval keeps the writes queued while they are read
+        // back, so the reads have to wait on them.
+        worker = std::make_unique<PersistenceWorker>(DATABASE_PATH, SQLite3Settings{}, 1000);
+        avatars = std::make_unique<SQLiteAvatarStore>(db, worker.get());
+        contacts = std::make_unique<SQLiteContactStore>(db, worker.get());
+        rooms = std::make_unique<SQLiteRoomStore>(db, worker.get());
+        mail = std::make_unique<SQLiteMailStore>(db, worker.get());
+    }
+
+    ~SQLiteStores() {
+        mail.reset();
+        rooms.reset();
+        contacts.reset();
+        avatars.reset();
+        worker.reset();
+
+        sqlite3_close(db);
+        std::remove(DATABASE_PATH.c_str());
+    }
+
+    sqlite3* db = nullptr;
+    std::unique_ptr<PersistenceWorker> worker;
+    std::unique_ptr<SQLiteAvatarStore> avatars;
+    std::unique_ptr<SQLiteContactStore> contacts;
+    std::unique_ptr<SQLiteRoomStore> rooms;
+    std::unique_ptr<SQLiteMailStore> mail;
+};
+
+AvatarRecord MakeAvatar(const std::u16string& name) {
+    AvatarRecord avatar;
+    avatar.userId = 7;
+    avatar.name = name;
+    avatar.address = u"SWG+galaxy";
+    avatar.attributes = 1;
+    return avatar;
+}
+
+RoomRecord MakeRoom(const std::u16string& name, const std::u16string& address) {
+    RoomRecord room;
+    room.creatorId = 1;
+    room.creatorName = u"creator";
+    room.creatorAddress = u"SWG+galaxy";
+    room.roomName = name;
+    room.roomTopic = u"topic";
+    room.roomAddress = address;
+    room.maxRoomSize = 50;
+    return room;
+}
+
+PersistentMessage MakeMessage(uint32_t avatarId, const std::u16string& category) {
+    PersistentMessage message;
+    message.header.avatarId = avatarId;
+    message.header.fromName = u"sender";
+    message.header.fromAddress = u"SWG+galaxy";
+    message.header.subject = u"subject";
+    message.header.category = category;
+    message.message = u"body";
+    message.oob = u"oob";
+    return message;
+}
+
+std::vector<uint32_t> FriendIds(const std::vector<FriendRecord>& friends) {
+    std::vector<uint32_t> ids;
+    for (auto& record : friends) {
+        ids.push_back(record.friendAvatarId);
+    }
+
+    std::sort(std::begin(ids), std::end(ids));
+    return ids;
+}
+
+void CheckAvatarStore(AvatarStore& store) {
+    auto firstId = store.InsertAvatar(MakeAvatar(u"first"));
+    auto secondId = store.InsertAvatar(MakeAvatar(u"second"));
+
+    THEN("inserted avatars get distinct ids and can be loaded by id and by name") {
+        REQUIRE(firstId != secondId);
+        REQUIRE(store.LoadAvatar(firstId)->name == u"first");
+        REQUIRE(store.LoadAvatar(u"second", u"SWG+galaxy")->avatarId == secondId);
+        REQUIRE_FALSE(store.LoadAvatar(u"second", u"SWG+other"));
+    }
+
+    THEN("inserting the same avatar twice fails") {
+        REQUIRE_THROWS_AS(store.InsertAvatar(MakeAvatar(u"first")), const ChatResultException&);
+    }
+
+    WHEN("an avatar is updated") {
+        auto avatar = *store.LoadAvatar(firstId);
+        avatar.attributes = 5;
+        store.UpdateAvatar(avatar);
+
+        THEN("loads return the update") {
+            REQUIRE(store.LoadAvatar(firstId)->attributes == 5);
+            REQUIRE(store.LoadAvatar(u"first", u"SWG+galaxy")->attributes == 5);
+        }
+    }
+
+    WHEN("an avatar is deleted") {
+        store.DeleteAvatar(firstId);
+
+        THEN("it can no longer be loaded or visited") {
+            REQUIRE_FALSE(store.LoadAvatar(firstId));
+            REQUIRE_FALSE(store.LoadAvatar(u"first", u"SWG+galaxy"));
+
+            std::vector<uint32_t> visited;
+            store.ForEachAvatar([&visited](const AvatarRecord& record) { visited.push_back(record.avatarId); });
+            REQUIRE(visited == std::vector<uint32_t>{secondId});
+        }
+
+        AND_WHEN("an avatar with the same name is inserted") {
+            auto recreatedId = store.InsertAvatar(MakeAvatar(u"first"));
+
+            THEN("it is stored under a new id") {
+                REQUIRE(recreatedId != firstId);
+                REQUIRE(store.LoadAvatar(u"first", u"SWG+galaxy")->avatarId == recreatedId);
+            }
+        }
+    }
+}
+
+void CheckContactStore(ContactStore& store) {
+    store.AddFriend(1, 2, u"hello");
+    store.AddFriend(1, 3, u"");
+    store.AddIgnore(1, 4);
+
+    THEN("added contacts can be loaded") {
+        auto friends = store.LoadFriends(1);
+        REQUIRE(FriendIds(friends) == (std::vector<uint32_t>{2, 3}));
+        REQUIRE(store.LoadIgnores(1).size() == 1);
+        REQUIRE(store.LoadIgnores(1)[0].ignoreAvatarId == 4);
+        REQUIRE(store.LoadFriends(2).empty());
+    }
+
+    WHEN("a friend comment is updated") {
+        store.UpdateFriendComment(1, 3, u"updated");
+
+        THEN("loads return the new comment") {
+            for (auto& record : store.LoadFriends(1)) {
+                REQUIRE(record.comment == (record.friendAvatarId == 3 ? u"updated" : u"hello"));
+            }
+        }
+    }
+
+    WHEN("contacts are removed") {
+        store.RemoveFriend(1, 2);
+        store.RemoveIgnore(1, 4);
+
+        THEN("they are no longer loaded or visited") {
+            REQUIRE(FriendIds(store.LoadFriends(1)) == std::vector<uint32_t>{3});
+            REQUIRE(store.LoadIgnores(1).empty());
+
+            size_t friendCount = 0;
+            size_t ignoreCount = 0;
+            store.ForEachFriend([&friendCount](const FriendRecord&) { ++friendCount; });
+            store.ForEachIgnore([&ignoreCount](const IgnoreRecord&) { ++ignoreCount; });
+            REQUIRE(friendCount == 1);
+            REQUIRE(ignoreCount == 0);
+        }
+    }
+}
+
+void CheckRoomStore(RoomStore& store) {
+    auto roomId = store.InsertRoom(MakeRoom(u"lobby", u"SWG+galaxy+lobby"));
+    store.InsertRoom(MakeRoom(u"lobby", u"SWH+galaxy+lobby"));
+
+    THEN("rooms are loaded by address prefix") {
+        auto rooms = store.LoadRooms(u"SWG+galaxy");
+        REQUIRE(rooms.size() == 1);
+        REQUIRE(rooms[0].roomId == roomId);
+        REQUIRE(rooms[0].roomTopic == u"topic");
+    }
+
+    THEN("inserting the same room twice fails") {
+        REQUIRE_THROWS_AS(store.InsertRoom(MakeRoom(u"lobby", u"SWG+galaxy+lobby")), const ChatResultException&);
+    }
+
+    WHEN("members are added and removed") {
+        store.AddRoomMember(RoomRole::MODERATOR, roomId, 10);
+        store.AddRoomMember(RoomRole::MODERATOR, roomId, 11);
+        store.AddRoomMember(RoomRole::BANNED, roomId, 12);
+        store.RemoveRoomMember(RoomRole::MODERATOR, roomId, 10);
+
+        THEN("each role loads its own members") {
+            REQUIRE(store.LoadRoomMembers(RoomRole::MODERATOR, roomId) == std::vector<uint32_t>{11});
+            REQUIRE(store.LoadRoomMembers(RoomRole::BANNED, roomId) == std::vector<uint32_t>{12});
+            REQUIRE(store.LoadRoomMembers(RoomRole::ADMINISTRATOR, roomId).empty());
+        }
+    }
+
+    WHEN("a room is deleted") {
+        store.DeleteRoom(roomId);
+
+        THEN("it is no longer loaded") {
+            REQUIRE(store.LoadRooms(u"SWG+galaxy").empty());
+        }
+
+        AND_WHEN("a room with the same name and address is inserted") {
+            auto recreatedId = store.InsertRoom(MakeRoom(u"lobby", u"SWG+galaxy+lobby"));
+
+            THEN("it is stored under a new id") {
+                REQUIRE(recreatedId != roomId);
+                REQUIRE(store.LoadRooms(u"SWG+galaxy").size() == 1);
+            }
+        }
+    }
+}
+
+void CheckMailStore(MailStore& store) {
+    auto firstId = store.InsertMessage(MakeMessage(1, u"news"));
+    auto secondId = store.InsertMessage(MakeMessage(1, u"trade"));
+    store.InsertMessage(MakeMessage(2, u"news"));
+
+    THEN("inserted messages can be loaded by their recipient") {
+        REQUIRE(firstId != secondId);
+        REQUIRE(store.LoadMessageHeaders(1).size() == 2);
+
+        auto message = store.LoadMessage(1, firstId);
+        REQUIRE(message);
+        REQUIRE(message->message == u"body");
+        REQUIRE(message->oob == u"oob");
+        REQUIRE(message->header.status == PersistentState::NEW);
+
+        REQUIRE_FALSE(store.LoadMessage(2, firstId));
+    }
+
+    WHEN("a message is deleted") {
+        store.UpdateMessageStatus(1, firstId, PersistentState::DELETED);
+
+        THEN("its header is no longer listed") {
+            auto headers = store.LoadMessageHeaders(1);
+            REQUIRE(headers.size() == 1);
+            REQUIRE(headers[0].messageId == secondId);
+        }
+    }
+
+    WHEN("a category is marked read") {
+        store.UpdateMessageStatus(1, u"news", PersistentState::READ);
+
+        THEN("only that recipient's messages in the category change") {
+            REQUIRE(store.LoadMessage(1, firstId)->header.status == PersistentState::READ);
+            REQUIRE(store.LoadMessage(1, secondId)->header.status == PersistentState::NEW);
+            REQUIRE(store.LoadMessageHeaders(2)[0].status == PersistentState::NEW);
+        }
+    }
+}
+
+} // namespace
+
+SCENARIO("avatar stores return their own earlier writes", "[storage]") {
+    GIVEN("in-memory stores") {
+        InMemoryStores stores;
+        CheckAvatarStore(stores.avatars);
+    }
+
+    GIVEN("SQLite stores") {
+        SQLiteStores stores;
+        CheckAvatarStore(*stores.avatars);
+    }
+}
+
+SCENARIO("contact stores return their own earlier writes", "[storage]") {
+    GIVEN("in-memory stores") {
+        InMemoryStores stores;
+        CheckContactStore(stores.contacts);
+    }
+
+    GIVEN("SQLite stores") {
+        SQLiteStores stores;
+        CheckContactStore(*stores.contacts);
+    }
+}
+
+SCENARIO("room stores return their own earlier writes", "[storage]") {
+    GIVEN("in-memory stores") {
+        InMemoryStores stores;
+        CheckRoomStore(stores.rooms);
+    }
+
+    GIVEN("SQLite stores") {
+        SQLiteStores stores;
+        CheckRoomStore(*stores.rooms);
+    }
+}
+
+SCENARIO("mail stores return their own earlier writes", "[storage]") {
+    GIVEN("in-memory stores") {
+        InMemoryStores stores;
+        CheckMailStore(stores.mail);
+    }
+
+    GIVEN("SQLite stores") {
+        SQLiteStores stores;
+        CheckMailStore(*stores.mail);
+    }
+}
@@ -0,0 +1,162 @@
+#include "catch.hpp"
+
+#include "PersistenceWorker.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const std::string DATABASE_PATH = "persistence_worker_tests.db";
+
+int CountRows(sqlite3* db) {
+    SQLite3Statement stmt{db, "SELECT COUNT(*) FROM avatar"};
+    return stmt.Step() ? stmt.ColumnInt(0) : -1;
+}
+
+PersistenceWorker::Command InsertAvatar(const std::string& name) {
+    return [name](SQLite3StatementCache& statements) {
+        auto stmt = statements.Prepare("INSERT INTO avatar (name) VALUES (@name)");
+        stmt->BindText("@name", name);
+        stmt->Execute();
+    };
+}
+
+} // namespace
+
+SCENARIO("queued writes are committed by the persistence worker", "[persistence]") {
+    GIVEN("a database file with one stored avatar") {
+        std::remove(DATABASE_PATH.c_str());
+
+        sqlite3* db;
+        REQUIRE(sqlite3_open(DATABASE_PATH.c_str(), &db) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(db, "CREATE TABLE avatar (id INTEGER PRIMARY KEY, name TEXT);"
+                                 "INSERT INTO avatar (name) VALUES ('stored')", 0, 0, 0) == SQLITE_OK);
+
+        // A rollback journal makes a reader on another connection block the
+        // worker's COMMIT rather than its writes.
+        SQLite3Settings settings;
+        settings.journalMode = "delete";
+        settings.busyTimeout = 0;
+
+        {
+            PersistenceWorker worker{DATABASE_PATH, settings, 10};
+
+            WHEN("a command in a batch throws") {
+                worker.Enqueue("InsertAvatar", InsertAvatar("first"));
+                worker.Enqueue("Throw", [](SQLite3StatementCache&) { throw SQLite3Exception{SQLITE_ERROR, "failed"}; });
+                worker.Enqueue("InsertAvatar", InsertAvatar("second"));
+                worker.Flush();
+
+                THEN("the failure is counted and the rest of the batch is committed") {
+                    REQUIRE(worker.GetFailedCount() == 1);
+                    REQUIRE(worker.GetCommittedCount() == 3);
+                    REQUIRE(CountRows(db) == 3);
+                }
+            }
+
+            WHEN("a reader holds the database while a batch commits") {
+                SQLite3Statement reader{db, "SELECT name FROM avatar"};
+                REQUIRE(reader.Step());
+
+                worker.Enqueue("InsertAvatar", InsertAvatar("first"));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+                THEN("the commit waits for the reader instead of dropping the batch") {
+                    REQUIRE(worker.GetCommittedCount() == 0);
+
+                    reader.Reset();
+                    worker.Flush();
+
+                    REQUIRE(worker.GetFailedCount() == 0);
+                    REQUIRE(CountRows(db) == 2);
+                }
+            }
+        }
+
+        sqlite3_close(db);
+        std::remove(DATABASE_PATH.c_str());
+    }
+}
+
+SCENARIO("reads only wait for the writes queued for the rows they read", "[persistence]") {
+    GIVEN("a persistence worker and the pending writes of a store") {
+        std::remove(DATABASE_PATH.c_str());
+
+        {
+            PersistenceWorker worker{DATABASE_PATH, SQLite3Settings{}, 10};
+            PendingWrites<uint32_t> writes{&worker};
+
+            WHEN("a write for one avatar is still being applied") {
+                std::promise<void> release;
+                auto applied = release.get_future().share();
+                writes.Enqueue(2, "Block", [applied](SQLite3StatementCache&) { applied.wait(); });
+
+                writes.WaitFor(1);
+                auto pending = writes.IsPending(2);
+                release.set_value();
+
+                THEN("a read of another avatar does not wait for it") {
+                    REQUIRE(pending);
+                }
+
+                AND_THEN("a read of that avatar waits until it is committed") {
+                    writes.WaitFor(2);
+                    REQUIRE_FALSE(writes.IsPending(2));
+                    REQUIRE(worker.GetCommittedCount() == 1);
+                }
+            }
+        }
+
+        std::remove(DATABASE_PATH.c_str());
+    }
+}
+
+SCENARIO("writes queued from several threads are flushed in sequence order", "[persistence]") {
+    GIVEN("a persistence worker and four producer threads") {
+        std::remove(DATABASE_PATH.c_str());
+
+        {
+            PersistenceWorker worker{DATABASE_PATH, SQLite3Settings{}, 1};
+            const int perThread = 500;
+
+            WHEN("each thread flushes up to its own last write") {
+                std::atomic<int> shortFlushes{0};
+                std::vector<std::thread> producers;
+
+                for (int i = 0; i < 4; ++i) {
+                    producers.emplace_back([&worker, &shortFlushes]() {
+                        auto applied = std::make_shared<std::atomic<int>>(0);
+
+                        uint64_t sequence = 0;
+                        for (int j = 0; j < perThread; ++j) {
+                            sequence = worker.Enqueue("Count", [applied](SQLite3StatementCache&) { ++*applied; });
+                        }
+
+                        worker.Flush(sequence);
+                        if (applied->load() != perThread) {
+                            ++shortFlushes;
+                        }
+                    });
+                }
+
+                for (auto& producer : producers) {
+                    producer.join();
+                }
+
+                THEN("every flush saw all of its thread's writes applied") {
+                    REQUIRE(shortFlushes == 0);
+                    REQUIRE(worker.GetCommittedCount() == 4 * perThread);
+                }
+            }
+        }
+
+        std::remove(DATABASE_PATH.c_str());
+    }
+}